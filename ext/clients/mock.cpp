@@ -0,0 +1,333 @@
+// Offline broker for load and latency testing. Candles are replayed from a
+// candle store, or made up for tickers that are not in it, and orders are
+// filled at the price of the current candle.
+//
+// keys: candle store folder, latency in ms, jitter in ms, starting balance
+
+#define KEY_COUNT 4
+#define MAX_CANDLES 5000
+
+#include <api/client_api.h>
+#include <data/candlestore.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#define MOCK_FEE 0.0001
+#define MOCK_MARGIN_RATE 0.02
+
+struct MockPosition
+{
+	double shares = 0.0;
+	double price = 0.0;
+};
+
+std::unique_ptr<CandleStore> store;
+unsigned latency = 0;
+unsigned jitter = 0;
+double balance = 0.0;
+unsigned leverage = 1;
+std::unordered_map<std::string, MockPosition> positions;
+std::mt19937 rng(0);
+std::mutex mtx;
+
+const char *init(const char** credentials)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	store = std::make_unique<CandleStore>(credentials[0]);
+	latency = std::strtoul(credentials[1], nullptr, 10);
+	jitter = std::strtoul(credentials[2], nullptr, 10);
+	balance = std::strtod(credentials[3], nullptr);
+
+	if (balance <= 0.0) return "balance must be above 0";
+
+	return NULL;
+}
+
+// the account is behind mtx and the candles are behind the store's own mutex
+uint32_t thread_safe() { return 1; }
+
+// waits as long as a request to a broker would
+void simulate_latency()
+{
+	unsigned ms;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		ms = latency;
+		if (jitter > 0) ms += rng() % (jitter + 1);
+	}
+
+	if (ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// candle of a ticker that starts at time, which is a multiple of interval
+Candle get_candle(const std::string& ticker, unsigned interval, long long time)
+{
+	long long index = time / interval;
+
+	try
+	{
+		std::shared_ptr<const CandleMap> map = store->load(ticker, interval);
+
+		// stored candles are played on a loop
+		if (!map->empty())
+		{
+			return map->history()[index % map->size()];
+		}
+	}
+	catch (const std::exception& e)
+	{
+		// made up instead
+	}
+
+	// made up prices are waves that are different for every ticker
+	double seed = (double)(std::hash<std::string>()(ticker) % 1000);
+	auto price = [&](long long i)
+	{
+		return 100.0 * (1.0 + 0.05 * std::sin(i * 0.01 + seed)
+			+ 0.01 * std::sin(i * 0.13 + seed * 2.0));
+	};
+
+	double open = price(index);
+	double close = price(index + 1);
+	double spread = std::abs(close - open) * 0.5 + 0.01;
+
+	return Candle(open, std::max(open, close) + spread,
+		std::min(open, close) - spread, close,
+		100.0 + (double)((index + (long long)seed) % 50));
+}
+
+// start of the candle that is open now
+long long current_candle(unsigned interval)
+{
+	long long now = time(NULL);
+	return now - now % interval;
+}
+
+double get_price(const std::string& ticker)
+{
+	return get_candle(ticker, MIN1, current_candle(MIN1)).close();
+}
+
+// writes count candles that end with the one that is open now
+void write_candles(PriceHistory& hist, const char *ticker, unsigned count)
+{
+	unsigned interval = hist.interval();
+	long long last = current_candle(interval);
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		long long time = last - (long long)(count - 1 - i) * interval;
+		hist.set(i, get_candle(ticker, interval, time), time);
+	}
+}
+
+const char *get_price_history(PriceHistory* out, const char *ticker)
+{
+	if (!to_interval(out->interval())) return "interval given is not valid";
+
+	simulate_latency();
+	write_candles(*out, ticker, out->size());
+
+	return NULL;
+}
+
+const char *get_price_history_since(PriceHistory* out, uint32_t* count,
+	const char *ticker, int64_t since)
+{
+	unsigned interval = out->interval();
+	if (!to_interval(interval)) return "interval given is not valid";
+
+	simulate_latency();
+
+	long long last = current_candle(interval);
+	long long first = since - since % interval;
+	long long received = (last >= first) ? (last - first) / interval + 1 : 0;
+	unsigned n = (received > out->size()) ? out->size() : (unsigned)received;
+
+	write_candles(*out, ticker, n);
+	*count = n;
+
+	return NULL;
+}
+
+const char *get_price_histories_since(PriceHistory** outs, uint32_t* counts,
+	const char** tickers, const int64_t* since, const char** errors,
+	uint32_t ticker_count)
+{
+	// one request for all of them
+	simulate_latency();
+
+	for (uint32_t i = 0; i < ticker_count; i++)
+	{
+		unsigned interval = outs[i]->interval();
+		long long last = current_candle(interval);
+		long long first = since[i] - since[i] % interval;
+		long long received = (last >= first) ? (last - first) / interval + 1 : 0;
+		unsigned n = (received > outs[i]->size()) ? outs[i]->size() : (unsigned)received;
+
+		counts[i] = 0;
+		errors[i] = to_interval(interval) ? NULL : "interval given is not valid";
+		if (errors[i]) continue;
+
+		write_candles(*outs[i], tickers[i], n);
+		counts[i] = n;
+	}
+
+	return NULL;
+}
+
+// unrealized profit of every position
+double unrealized()
+{
+	double total = 0.0;
+
+	for (const auto& pair : positions)
+	{
+		total += pair.second.shares * (get_price(pair.first) - pair.second.price);
+	}
+
+	return total;
+}
+
+double margin_used()
+{
+	double total = 0.0;
+
+	for (const auto& pair : positions)
+	{
+		total += std::abs(pair.second.shares) * pair.second.price;
+	}
+
+	return total / leverage;
+}
+
+const char *get_account(Account* out)
+{
+	simulate_latency();
+
+	std::lock_guard<std::mutex> lock(mtx);
+	double equity = balance + unrealized();
+	double used = margin_used();
+	double available = equity - used;
+
+	*out =
+	{
+		balance,
+		(available > 0.0) ? available * leverage : 0.0,
+		used,
+		equity,
+		(int)leverage,
+		true
+	};
+
+	return NULL;
+}
+
+const char *market_order(const char* ticker, double amount)
+{
+	if (amount == 0.0) return "order amount of 0 is not allowed";
+
+	simulate_latency();
+
+	std::lock_guard<std::mutex> lock(mtx);
+	MockPosition& pos = positions[ticker];
+	double price = get_price(ticker);
+
+	// the spread is paid on every order
+	balance -= std::abs(amount) * price * MOCK_FEE;
+
+	// adding to the position or opening one
+	if (pos.shares * amount >= 0.0)
+	{
+		double shares = pos.shares + amount;
+		pos.price = (pos.shares * pos.price + amount * price) / shares;
+		pos.shares = shares;
+		return NULL;
+	}
+
+	// closing some or all of it, which realizes its profit
+	double closed = (std::abs(amount) < std::abs(pos.shares)) ? -amount : pos.shares;
+	balance += closed * (price - pos.price);
+	pos.shares += amount;
+
+	// an order past the position opens the other side at this price
+	if (pos.shares * closed < 0.0) pos.price = price;
+	if (pos.shares == 0.0) positions.erase(ticker);
+
+	return NULL;
+}
+
+const char *get_position(Position* out, const char* ticker)
+{
+	simulate_latency();
+
+	std::lock_guard<std::mutex> lock(mtx);
+	double price = get_price(ticker);
+	auto iter = positions.find(ticker);
+
+	if (iter == positions.end())
+	{
+		*out = { 0.0, MOCK_FEE, 1.0, price, 0.0 };
+		return NULL;
+	}
+
+	const MockPosition& pos = iter->second;
+	*out = { std::abs(pos.shares) * pos.price, MOCK_FEE, 1.0, price, pos.shares };
+
+	return NULL;
+}
+
+const char *set_leverage(uint32_t multiplier)
+{
+	if (multiplier == 0) return "leverage of 0 is not allowed";
+	if (multiplier > 1.0 / MOCK_MARGIN_RATE) return "leverage higher than maximum (50) is not allowed";
+
+	std::lock_guard<std::mutex> lock(mtx);
+	leverage = multiplier;
+
+	return NULL;
+}
+
+// the mock market never closes
+uint32_t secs_till_market_close()
+{
+	return WEEK;
+}
+
+const char* to_interval(uint32_t interval)
+{
+	switch(interval)
+	{
+	case SEC5:		return "S5";
+	case SEC10:		return "S10";
+	case SEC15:		return "S15";
+	case SEC30:		return "S30";
+	case MIN1:		return "M1";
+	case MIN2:		return "M2";
+	case MIN4:		return "M4";
+	case MIN5:		return "M5";
+	case MIN10:		return "M10";
+	case MIN15:		return "M15";
+	case MIN30:		return "M30";
+	case HOUR1:		return "H1";
+	case HOUR2:		return "H2";
+	case HOUR3:		return "H3";
+	case HOUR4:		return "H4";
+	case HOUR6:		return "H6";
+	case HOUR8:		return "H8";
+	case HOUR12:	return "H12";
+	case DAY:		return "D";
+	case WEEK:		return "W";
+	default:		return nullptr;
+	}
+}
@@ -3,21 +3,57 @@
 
 #include <iostream>
 #include <api/client_api.h>
+#include <api/candleparser.h>
 #include <ctime>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+#define OANDA_HOST "api-fxpractice.oanda.com"
+#define OANDA_STREAM_HOST "stream-fxpractice.oanda.com"
 
 std::string accountid, token;
 
-httplib::SSLClient client("api-fxpractice.oanda.com");
+// warm connections so that requests do not each do a tls handshake
+ConnectionPool connections(OANDA_HOST);
 
 const char *init(const char** credentials)
 {
 	accountid = credentials[0];
 	token = credentials[1];
-	client.set_bearer_token_auth(token.c_str());
+	connections.configure([](httplib::SSLClient& cli)
+	{
+		cli.set_bearer_token_auth(token.c_str());
+		// candle times as epoch seconds instead of RFC3339
+		cli.set_default_headers({ { "Accept-Datetime-Format", "UNIX" } });
+	});
 	return NULL;
 
 }
 
+// every request has a connection of its own
+uint32_t thread_safe() { return 1; }
+
+// writes count candles of the json array, starting at first, into hist
+void read_candles(PriceHistory& hist, const Data& candles_json, unsigned first,
+	unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+	{
+		const Data& candle = candles_json[first + i];
+		const Data& mid = candle["mid"];
+		
+		hist.set(i,
+		{
+			mid["o"].to_double(),
+			mid["h"].to_double(),
+			mid["l"].to_double(),
+			mid["c"].to_double(),
+			candle["volume"].to_double()
+		}, (long long)candle["time"].to_double());
+	}
+}
+
 const char *get_price_history(PriceHistory* out, const char *ticker)
 {
 	std::string url = "/v3/instruments/" + std::string(ticker) + "/candles";
@@ -36,51 +72,327 @@ const char *get_price_history(PriceHistory* out, const char *ticker)
 
 	url += '?' + httplib::detail::params_to_query_str(p);
 	
-	auto res = client.Get(url.c_str());
+	auto res = connections.acquire()->Get(url.c_str());
 
 	// if there was an error, return it
 	const char *err = res_err(res);
 	if (err) return err;
 
+	// up to thousands of candles are read without building a json tree
+	CandleParser parser(res->body);
+	unsigned received;
+
+	err = parser.find_candles();
+	if (err) return err;
+
+	err = parser.count(received);
+	if (err) return err;
+
+	if (received == 0)
+	{
+		return "no candles were received";
+	}
+	else if (received != hist.size())
+	{
+		return "not all candles were received";
+	}
+
+	return parser.read(hist, 0, received);
+}
+
+const char *get_price_history_since(PriceHistory* out, uint32_t* count,
+	const char *ticker, int64_t since)
+{
+	std::string url = "/v3/instruments/" + std::string(ticker) + "/candles";
+	PriceHistory& hist = *out;
+	const char* interval_str = to_interval(hist.interval());
+
+	if (!interval_str)
+	{
+		return "interval given is not valid";
+	}
+
+	// oanda gives at most count candles after 'from', so after a long gap
+	// that would miss the newest ones. The newest candles are asked for
+	// instead, enough of them to reach back to since.
+	long long missing = ((long long)std::time(nullptr) - since) / hist.interval() + 2;
+	if (missing < 1) missing = 1;
+	if (missing > hist.size()) missing = hist.size();
+	if (missing > MAX_CANDLES) missing = MAX_CANDLES;
+
+	httplib::Params p = {
+		{ "granularity", interval_str },
+		{ "count", std::to_string(missing) }
+	};
+
+	url += '?' + httplib::detail::params_to_query_str(p);
+
+	auto res = connections.acquire()->Get(url.c_str());
+
+	const char *err = res_err(res);
+	if (err) return err;
+
+	CandleParser parser(res->body);
+	unsigned received;
+
+	err = parser.find_candles();
+	if (err) return err;
+
+	err = parser.count(received);
+	if (err) return err;
+
+	// only the newest ones fit
+	unsigned n = (received > hist.size()) ? hist.size() : received;
+
+	err = parser.read(hist, received - n, n);
+	if (err) return err;
+
+	// leaving out the ones from before since
+	unsigned first = 0;
+	while (first < n && hist.timestamp(first) < since) first++;
+
+	for (unsigned i = first; i < n; i++)
+	{
+		hist.set(i - first, hist[i], hist.timestamp(i));
+	}
+
+	*count = n - first;
+
+	return NULL;
+}
+
+// latest candles of several instruments, each with its own granularity
+const char *fetch_latest_candles(PriceHistory** outs,
+	uint32_t* counts, const char** tickers, const int64_t* since,
+	const char** errors, uint32_t ticker_count)
+{
+	std::string specs;
+	// index of every ticker by its specification
+	std::unordered_map<std::string, uint32_t> indices;
+
+	for (uint32_t i = 0; i < ticker_count; i++)
+	{
+		counts[i] = 0;
+		errors[i] = NULL;
+
+		const char* interval_str = to_interval(outs[i]->interval());
+
+		if (!interval_str)
+		{
+			errors[i] = "interval given is not valid";
+			continue;
+		}
+
+		std::string spec = std::string(tickers[i]) + ':' + interval_str;
+		indices[spec] = i;
+
+		if (!specs.empty()) specs += ',';
+		specs += spec + ":M";
+	}
+
+	if (indices.empty()) return NULL;
+
+	std::string url = "/v3/accounts/" + accountid + "/candles/latest?"
+		+ httplib::detail::params_to_query_str({ { "candleSpecifications", specs } });
+
+	auto res = connections.acquire()->Get(url.c_str());
+
+	const char *err = res_err(res);
+	if (err) return err;
+
 	Data json = Data::parse_json(res->body);
 	if (json.is_error())
 	{
 		return "json failed to parse";
 	}
 
-	const Data& candles_json = json["candles"];
+	const Data& latest_json = json["latestCandles"];
 
-	if (candles_json.empty() || !candles_json.is_array())
+	if (!latest_json.is_array())
 	{
 		return "no candles were received";
 	}
-	else if (candles_json.size() != hist.size())
+
+	std::vector<bool> received(ticker_count, false);
+
+	for (const Data& latest : latest_json.to_array())
 	{
-		return "not all candles were received";
+		std::string spec = latest["instrument"].to_string() + ':'
+			+ latest["granularity"].to_string();
+		auto iter = indices.find(spec);
+
+		if (iter == indices.end()) continue;
+
+		uint32_t i = iter->second;
+		const Data& candles_json = latest["candles"];
+		PriceHistory& hist = *outs[i];
+
+		received[i] = true;
+
+		if (!candles_json.is_array()) continue;
+
+		// skipping the ones before since
+		unsigned total = candles_json.size();
+		unsigned first = 0;
+
+		while (first < total && (int64_t)candles_json[first]["time"].to_double() < since[i]) first++;
+
+		// only the newest ones fit
+		unsigned n = total - first;
+		if (n > hist.size()) n = hist.size();
+
+		read_candles(hist, candles_json, total - n, n);
+		counts[i] = n;
 	}
 
-	for (int i = 0; i < hist.size(); i++)
+	for (const auto& pair : indices)
 	{
-		const Data& candle = candles_json[i];
-		const Data& mid = candle["mid"];
-		
-		hist[i] =
-		{
-			mid["o"].to_double(),
-			mid["h"].to_double(),
-			mid["l"].to_double(),
-			mid["c"].to_double(),
-			candle["volume"].to_double()
-		};
+		if (!received[pair.second]) errors[pair.second] = "no candles were received";
 	}
 
 	return NULL;
 }
 
+const char *get_price_histories_since(PriceHistory** outs, uint32_t* counts,
+	const char** tickers, const int64_t* since, const char** errors,
+	uint32_t ticker_count)
+{
+	return fetch_latest_candles(outs, counts, tickers, since, errors,
+		ticker_count);
+}
+
+const char *get_price_histories_since_async(PriceHistory** outs,
+	uint32_t* counts, const char** tickers, const int64_t* since,
+	const char** errors, uint32_t ticker_count,
+	void (*done)(void* data, const char* error), void* data)
+{
+	std::thread([=]()
+	{
+		done(data, fetch_latest_candles(outs, counts, tickers, since, errors,
+			ticker_count));
+	}).detach();
+
+	return NULL;
+}
+
+struct PriceStream
+{
+	httplib::SSLClient client;
+	std::thread thread;
+	std::atomic<bool> stopped = false;
+
+	PriceStream() :
+	client(OANDA_STREAM_HOST)
+	{}
+};
+
+// passes on the price in a line of the stream, the rest are heartbeats
+void read_price_line(const std::string& line,
+	const std::unordered_map<std::string, uint32_t>& indices,
+	void (*on_tick)(void*, uint32_t, double, int64_t), void* data)
+{
+	Data json = Data::parse_json(line);
+	if (json.is_error() || json["type"].to_string() != "PRICE") return;
+
+	auto iter = indices.find(json["instrument"].to_string());
+	if (iter == indices.end()) return;
+
+	const Data& bids = json["bids"];
+	const Data& asks = json["asks"];
+	if (!bids.is_array() || !asks.is_array() || bids.empty() || asks.empty()) return;
+
+	// candles are of the mid price
+	double price = (bids[0]["price"].to_double() + asks[0]["price"].to_double()) / 2.0;
+
+	on_tick(data, iter->second, price, (int64_t)json["time"].to_double());
+}
+
+const char *start_price_stream(void** out, const char** tickers,
+	uint32_t ticker_count,
+	void (*on_tick)(void* data, uint32_t index, double price, int64_t time),
+	void (*on_end)(void* data, const char* error), void* data)
+{
+	std::string instruments;
+	std::unordered_map<std::string, uint32_t> indices;
+
+	for (uint32_t i = 0; i < ticker_count; i++)
+	{
+		if (!instruments.empty()) instruments += ',';
+		instruments += tickers[i];
+		indices[tickers[i]] = i;
+	}
+
+	if (indices.empty()) return "no tickers were given";
+
+	std::string url = "/v3/accounts/" + accountid + "/pricing/stream?"
+		+ httplib::detail::params_to_query_str({ { "instruments", instruments } });
+
+	PriceStream* stream = new PriceStream();
+	stream->client.set_bearer_token_auth(token.c_str());
+	stream->client.set_default_headers({ { "Accept-Datetime-Format", "UNIX" } });
+	// a heartbeat comes every 5 seconds, so a longer silence is a dead connection
+	stream->client.set_read_timeout(20, 0);
+
+	stream->thread = std::thread([=]()
+	{
+		// the prices are json objects, one per line, that can be split between chunks
+		std::string buffer;
+
+		auto res = stream->client.Get(url.c_str(), [&](const char* chunk, size_t length)
+		{
+			buffer.append(chunk, length);
+
+			size_t start = 0;
+			size_t end;
+
+			while (!stream->stopped && (end = buffer.find('\n', start)) != std::string::npos)
+			{
+				read_price_line(buffer.substr(start, end - start), indices, on_tick, data);
+				start = end + 1;
+			}
+
+			buffer.erase(0, start);
+
+			return !stream->stopped;
+		});
+
+		if (stream->stopped) return;
+
+		if (!res)
+		{
+			on_end(data, "failed to get a response");
+		}
+		else if (res->status < 200 || res->status > 299)
+		{
+			on_end(data, "response status was not okay");
+		}
+		else
+		{
+			on_end(data, "price stream was closed");
+		}
+	});
+
+	*out = stream;
+
+	return NULL;
+}
+
+void stop_price_stream(void* data)
+{
+	PriceStream* stream = (PriceStream*)data;
+
+	stream->stopped = true;
+	// interrupts the request if it is waiting on the next chunk
+	stream->client.stop();
+	stream->thread.join();
+
+	delete stream;
+}
+
 const char *get_account(Account *out)
 {
 	std::string url = "/v3/accounts/" + accountid + "/summary";
-	auto res = client.Get(url.c_str());
+	auto res = connections.acquire()->Get(url.c_str());
 
 	const char *err = res_err(res);
 	if (err) return err;
@@ -120,7 +432,7 @@ const char *market_order(const char *ticker, double amount)
 		{ "units", std::to_string(amount) }
 	});
 
-	auto res = client.Post(url.c_str(), req.to_json(), JSON_FORMAT);
+	auto res = connections.acquire()->Post(url.c_str(), req.to_json(), JSON_FORMAT);
 
 	// if error exit
 	const char *error = res_err(res);
@@ -155,7 +467,7 @@ const char *get_position(Position* out, const char *ticker)
 {
 	// getting share count
 	std::string url = "/v3/accounts/" + accountid + "/positions/" + ticker;
-	auto res = client.Get(url.c_str());
+	auto res = connections.acquire()->Get(url.c_str());
 
 	const char *error = res_err(res);
 	if (error) return error;
@@ -184,7 +496,7 @@ const char *get_position(Position* out, const char *ticker)
 
 	// getting fee and price
 	url = "/v3/instruments/" + std::string(ticker) + "/candles?count=20&granularity=S5&price=BAM";
-	res = client.Get(url.c_str());
+	res = connections.acquire()->Get(url.c_str());
 
 	// exit if error
 	error = res_err(res);
@@ -219,7 +531,8 @@ const char *get_position(Position* out, const char *ticker)
 const char *set_leverage(uint32_t multiplier)
 {
 	std::string url = "/v3/accounts/" + accountid + "/configuration";
-	client.Patch(url.c_str());
+	auto cli = connections.acquire();
+	cli->Patch(url.c_str());
 	if (multiplier > 50)
 	{
 		return "leverage higher than maximum (50) is not allowed";
@@ -230,7 +543,7 @@ const char *set_leverage(uint32_t multiplier)
 	}
 	Data req;
 	req["marginRate"] = std::to_string(1.0 / (double)multiplier);
-	auto res = client.Patch(url.c_str(), req.to_json(), JSON_FORMAT);
+	auto res = cli->Patch(url.c_str(), req.to_json(), JSON_FORMAT);
 	
 	const char *error = res_err(res);
 	if (error) return error;
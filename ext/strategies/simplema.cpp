@@ -3,27 +3,10 @@
 
 #include <api/strategy_api.h>
 
-void EMA(Indicator& data, const PriceHistory& candles, unsigned range)
-{
-	double multiplier = 2.0 / (double)(range + 1);
-
-	double sum = 0.0;
-	for(int i = -range + 1; i <= 0; i++)
-	{
-		sum += candles[i].close();
-	}
-	data[0] = sum / (double)range;
-
-	for (int i = 1; i < data.size(); i++)
-	{
-		data[i] = candles[i].close() * multiplier + data[i - 1] * (1.0 - multiplier);
-	}
-}
-
 const std::vector<IndicatorConfig> config = 
 {
-	{ EMA, "EMA", "long" },
-	{ EMA, "EMA", "short" }
+	{ indicators::ema, "EMA", "long", indicators::stream::ema, indicators::batch::ema },
+	{ indicators::ema, "EMA", "short", indicators::stream::ema, indicators::batch::ema }
 };
 
 Action strategy(const Chart& chart)
@@ -0,0 +1,309 @@
+#ifndef DAYTRENDER_CANDLE_PARSER_H
+#define DAYTRENDER_CANDLE_PARSER_H
+
+// local includes
+#include <data/candle.h>
+#include <data/pricehistory.h>
+
+// standard library
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace daytrender
+{
+	/**
+	 * Reads the candles of a broker response straight into a history. The
+	 * json is scanned in place instead of being parsed into a tree, so
+	 * nothing is allocated and values that are not needed are only
+	 * skipped over. It expects an object with a "candles" array of
+	 * objects that have "time", "volume" and a "mid" object of "o", "h",
+	 * "l" and "c". Numbers can be quoted. Strings are not unescaped, which
+	 * the keys that are read never need.
+	 *
+	 * The json must stay alive and unchanged while the parser is used.
+	 */
+	class CandleParser
+	{
+	private:
+		const char *_begin;
+		const char *_pos;
+		const char *_end;
+		// start of the candles array
+		const char *_candles = nullptr;
+
+		static inline bool is_space(char c)
+		{
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+		}
+
+		static inline bool key_is(const char *key, size_t length, const char *name)
+		{
+			return length == std::strlen(name) && std::memcmp(key, name, length) == 0;
+		}
+
+		inline void skip_space()
+		{
+			while (_pos < _end && is_space(*_pos)) ++_pos;
+		}
+
+		inline bool consume(char c)
+		{
+			skip_space();
+			if (_pos == _end || *_pos != c) return false;
+			++_pos;
+			return true;
+		}
+
+		bool read_string(const char *&start, size_t& length)
+		{
+			if (!consume('"')) return false;
+
+			start = _pos;
+
+			while (_pos < _end && *_pos != '"')
+			{
+				if (*_pos == '\\') ++_pos;
+				++_pos;
+			}
+
+			if (_pos >= _end) return false;
+
+			length = _pos - start;
+			++_pos;
+
+			return true;
+		}
+
+		bool skip_value()
+		{
+			skip_space();
+			if (_pos == _end) return false;
+
+			const char *start;
+			size_t length;
+
+			if (*_pos == '"') return read_string(start, length);
+
+			if (*_pos != '{' && *_pos != '[')
+			{
+				// number, true, false or null
+				const char *first = _pos;
+				while (_pos < _end && !is_space(*_pos) && *_pos != ','
+					&& *_pos != '}' && *_pos != ']') ++_pos;
+				return _pos != first;
+			}
+
+			unsigned depth = 0;
+
+			do
+			{
+				skip_space();
+				if (_pos == _end) return false;
+
+				switch (*_pos)
+				{
+				case '"':
+					if (!read_string(start, length)) return false;
+					continue;
+
+				case '{':
+				case '[':
+					depth++;
+					break;
+
+				case '}':
+				case ']':
+					depth--;
+					break;
+				}
+
+				++_pos;
+			}
+			while (depth > 0);
+
+			return true;
+		}
+
+		// reads a number that may be quoted, like the prices of oanda
+		bool read_number(double& out)
+		{
+			skip_space();
+
+			bool quoted = _pos < _end && *_pos == '"';
+			if (quoted) ++_pos;
+
+			// the json ends in a null, so strtod cannot read past it
+			char *end;
+			out = std::strtod(_pos, &end);
+			if (end == _pos || end > _end) return false;
+			_pos = end;
+
+			return !quoted || consume('"');
+		}
+
+		// reads the next key and the colon after it
+		inline bool read_key(const char *&key, size_t& length)
+		{
+			return read_string(key, length) && consume(':');
+		}
+
+		bool read_mid(double *ohlc)
+		{
+			if (!consume('{')) return false;
+			if (consume('}')) return true;
+
+			do
+			{
+				const char *key;
+				size_t length;
+				if (!read_key(key, length)) return false;
+
+				bool ok;
+
+				if (length == 1 && *key == 'o') ok = read_number(ohlc[0]);
+				else if (length == 1 && *key == 'h') ok = read_number(ohlc[1]);
+				else if (length == 1 && *key == 'l') ok = read_number(ohlc[2]);
+				else if (length == 1 && *key == 'c') ok = read_number(ohlc[3]);
+				else ok = skip_value();
+
+				if (!ok) return false;
+			}
+			while (consume(','));
+
+			return consume('}');
+		}
+
+		bool read_candle(Candle& candle, long long& time)
+		{
+			double ohlc[4] = { 0.0, 0.0, 0.0, 0.0 };
+			double volume = 0.0;
+			double seconds = 0.0;
+
+			if (!consume('{')) return false;
+
+			if (!consume('}'))
+			{
+				do
+				{
+					const char *key;
+					size_t length;
+					if (!read_key(key, length)) return false;
+
+					bool ok;
+
+					if (key_is(key, length, "time")) ok = read_number(seconds);
+					else if (key_is(key, length, "volume")) ok = read_number(volume);
+					else if (key_is(key, length, "mid")) ok = read_mid(ohlc);
+					else ok = skip_value();
+
+					if (!ok) return false;
+				}
+				while (consume(','));
+
+				if (!consume('}')) return false;
+			}
+
+			candle = Candle(ohlc[0], ohlc[1], ohlc[2], ohlc[3], volume);
+			time = (long long)seconds;
+
+			return true;
+		}
+
+	public:
+		CandleParser(const std::string& json) :
+		_begin(json.c_str()),
+		_pos(_begin),
+		_end(_begin + json.size())
+		{}
+
+		/**
+		 * Moves to the candles array of the top level object
+		 */
+		const char *find_candles()
+		{
+			_pos = _begin;
+
+			if (!consume('{')) return "json failed to parse";
+			if (consume('}')) return "no candles were received";
+
+			do
+			{
+				const char *key;
+				size_t length;
+				if (!read_key(key, length)) return "json failed to parse";
+
+				if (key_is(key, length, "candles"))
+				{
+					skip_space();
+					if (_pos == _end || *_pos != '[') return "no candles were received";
+					_candles = _pos;
+					return nullptr;
+				}
+
+				if (!skip_value()) return "json failed to parse";
+			}
+			while (consume(','));
+
+			return "no candles were received";
+		}
+
+		/**
+		 * Counts the candles without reading them
+		 */
+		const char *count(unsigned& out)
+		{
+			if (!_candles) return "no candles were received";
+
+			_pos = _candles + 1;
+			out = 0;
+
+			if (consume(']')) return nullptr;
+
+			do
+			{
+				if (!skip_value()) return "json failed to parse";
+				out++;
+			}
+			while (consume(','));
+
+			if (!consume(']')) return "json failed to parse";
+
+			return nullptr;
+		}
+
+		/**
+		 * Writes count candles, after skipping the first ones, to the start
+		 * of a history
+		 */
+		const char *read(PriceHistory& hist, unsigned skip, unsigned count)
+		{
+			if (!_candles) return "no candles were received";
+			if (count > hist.size()) return "history is too short for the candles";
+
+			_pos = _candles + 1;
+
+			for (unsigned i = 0; i < skip + count; ++i)
+			{
+				if (i > 0 && !consume(',')) return "not all candles were received";
+
+				if (i < skip)
+				{
+					if (!skip_value()) return "json failed to parse";
+					continue;
+				}
+
+				Candle candle;
+				long long time;
+
+				if (!read_candle(candle, time)) return "json failed to parse";
+
+				hist.set(i - skip, candle, time);
+			}
+
+			return nullptr;
+		}
+	};
+}
+
+#endif
@@ -4,15 +4,18 @@
 // daytrender includes
 #include <data/asset.h>
 #include <data/account.h>
+#include <data/candlestore.h>
 #include <data/pricehistory.h>
 #include <data/position.h>
 #include <data/result.h>
 
 // standard library
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 // external libararies
 #include <hirzel/plugin.h>
@@ -24,12 +27,27 @@ namespace daytrender
 {
 	class Client
 	{
+	public:
+		// receives the error of every asset of a batch, nullptr if it updated
+		typedef std::function<void(const std::vector<const char*>&)> UpdateCallback;
+		// receives the index of the ticker, the price and its time
+		typedef std::function<void(unsigned, double, long long)> TickCallback;
+		// receives the error that ended a stream
+		typedef std::function<void(const char*)> StreamEndCallback;
+
 	private:
+		struct Batch;
+		struct Stream;
 
 		static std::unordered_map<std::string, std::shared_ptr<hirzel::Plugin>> _plugins;
+		static std::unordered_map<std::string, std::shared_ptr<CandleStore>> _stores;
+		static std::unordered_map<std::string, std::shared_ptr<std::mutex>> _locks;
 
 		std::string _filename;
 		std::shared_ptr<hirzel::Plugin> _plugin;
+		std::shared_ptr<CandleStore> _store;
+		// held during plugin calls unless the plugin is thread safe
+		std::shared_ptr<std::mutex> _lock;
 		
 		// init func
 
@@ -41,6 +59,18 @@ namespace daytrender
 		const char *(*_set_leverage)(uint32_t) = nullptr;
 		const char *(*_get_account)(Account*) = nullptr;
 		const char *(*_get_price_history)(PriceHistory*, const char*) = nullptr;
+		const char *(*_get_price_history_since)(PriceHistory*, uint32_t*, const char*, int64_t) = nullptr;
+		// batched functions of api version 2
+		const char *(*_get_price_histories_since)(PriceHistory**, uint32_t*,
+			const char**, const int64_t*, const char**, uint32_t) = nullptr;
+		const char *(*_get_price_histories_since_async)(PriceHistory**, uint32_t*,
+			const char**, const int64_t*, const char**, uint32_t,
+			void (*)(void*, const char*), void*) = nullptr;
+		// streaming functions of api version 2
+		const char *(*_start_price_stream)(void**, const char**, uint32_t,
+			void (*)(void*, uint32_t, double, int64_t),
+			void (*)(void*, const char*), void*) = nullptr;
+		void (*_stop_price_stream)(void*) = nullptr;
 		const char *(*_get_position)(Position*, const char*) = nullptr;
 		const char *(*_to_interval)(uint32_t) = nullptr;
 		uint32_t(*_secs_till_market_close)() = nullptr;
@@ -56,6 +86,33 @@ namespace daytrender
 		std::string get_filename(const hirzel::Data& config) const;
 		std::shared_ptr<hirzel::Plugin> get_plugin(const hirzel::Data& config,
 			const std::string& dir) const;
+		std::shared_ptr<CandleStore> get_store(const std::string& dir) const;
+		std::shared_ptr<std::mutex> get_lock() const;
+		void bind_functions();
+
+		inline std::unique_lock<std::mutex> lock_plugin() const
+		{
+			return _lock
+				? std::unique_lock<std::mutex>(*_lock)
+				: std::unique_lock<std::mutex>();
+		}
+
+	private: // price history
+
+		const char *fetch_price_history(PriceHistory& out, const std::string& ticker,
+			unsigned interval, unsigned count) const;
+		const char *sync_price_history(std::shared_ptr<const CandleMap>& map,
+			PriceHistory& fetched, unsigned& closed, const std::string& ticker,
+			unsigned interval, unsigned count) const;
+		const char *push_fetched(CandleWindow& window, long long since,
+			uint32_t count) const;
+		std::unique_ptr<Batch> make_batch(const std::vector<Asset*>& assets) const;
+		const char *fetch_batch(Batch& batch) const;
+		void finish_batch(Batch& batch, const char *error) const;
+		static void finish_async(void *data, const char *error);
+		static void receive_tick(void *data, uint32_t index, double price,
+			int64_t time);
+		static void receive_stream_end(void *data, const char *error);
 
 	public:
 		Client(const hirzel::Data& config, const std::string& dir);
@@ -74,6 +131,21 @@ namespace daytrender
 		Result<PriceHistory> get_price_history(const std::string& ticker,
 			unsigned interval, unsigned count) const;
 
+		Result<std::shared_ptr<const CandleMap>> get_stored_history(
+			const std::string& ticker, unsigned interval) const;
+
+		const char *update_price_history(CandleWindow& window,
+			const std::string& ticker) const;
+
+		std::vector<const char*> update_price_histories(
+			const std::vector<Asset*>& assets) const;
+		void update_price_histories_async(const std::vector<Asset*>& assets,
+			UpdateCallback done) const;
+
+		Result<std::shared_ptr<void>> stream_prices(
+			const std::vector<std::string>& tickers, TickCallback on_tick,
+			StreamEndCallback on_end) const;
+
 		Result<Position> get_position(const std::string& ticker) const;
 
 		const char *to_interval(int interval) const;
@@ -84,6 +156,11 @@ namespace daytrender
 			return get_price_history(asset.ticker(), asset.interval(), asset.candle_count());
 		}
 
+		inline const char *update_price_history(Asset& asset) const
+		{
+			return update_price_history(asset.candles(), asset.ticker());
+		}
+
 		const char *enter_position(const Asset& asset, double pct, bool short_shares);
 		const char *exit_position(const Asset& asset, bool short_shares);
 		const char *close_position(const Asset& asset);
@@ -105,17 +182,22 @@ namespace daytrender
 		inline const char *to_interval(unsigned multiplier) const
 		{
 			if (!_plugin) return nullptr;
+			auto lock = lock_plugin();
 			return _to_interval((uint32_t)multiplier);
 		}
 		
 		inline unsigned secs_till_market_close() const
 		{
 			if (!_plugin) return 0;
+			auto lock = lock_plugin();
 			return _secs_till_market_close();
 		}
 
 		// inline getter functions
 		inline bool is_bound() const { return (bool)_plugin; }
+		inline bool is_thread_safe() const { return !_lock; }
+		inline bool is_batched() const { return (bool)_get_price_histories_since; }
+		inline bool is_streaming() const { return (bool)_start_price_stream; }
 		inline const std::string& filename() const { return _filename; }
 		inline const std::string& filepath() const { return _plugin->filepath(); }
 	};
@@ -13,6 +13,7 @@
 
 // local includes
 #include <api/versions.h>
+#include <api/connectionpool.h>
 #include <api/interval.h>
 #include <data/account.h>
 #include <data/pricehistory.h>
@@ -66,8 +67,43 @@ extern "C"
 	uint32_t secs_till_market_close();
 	const char *to_interval(uint32_t interval);
 	const char *get_price_history(PriceHistory* out, const char *ticker);
+	// optional: fills out with up to out->size() of the newest candles that
+	// start at or after since, oldest first, and sets count to how many
+	const char *get_price_history_since(PriceHistory* out, uint32_t* count,
+		const char *ticker, int64_t since);
+	// optional: get_price_history_since for several tickers in one request.
+	// outs[i], counts[i], tickers[i] and since[i] are for the same ticker
+	// and errors[i] is set if only that ticker failed
+	const char *get_price_histories_since(PriceHistory** outs, uint32_t* counts,
+		const char** tickers, const int64_t* since, const char** errors,
+		uint32_t ticker_count);
+	// optional: starts get_price_histories_since and returns without
+	// waiting for it. done(data, error) is called from another thread once
+	// it is over, and every array must stay valid until then. The calls
+	// are not locked for the plugin, so the request must not share state
+	// with other functions. If an error is returned, done is not called.
+	const char *get_price_histories_since_async(PriceHistory** outs,
+		uint32_t* counts, const char** tickers, const int64_t* since,
+		const char** errors, uint32_t ticker_count,
+		void (*done)(void* data, const char* error), void* data);
+	// optional: starts streaming the prices of tickers and sets out to a
+	// handle of the stream. on_tick(data, index, price, time) is called
+	// from a thread of the plugin for every price, with the index of its
+	// ticker and its time in epoch seconds. If the stream fails,
+	// on_end(data, error) is called and no more ticks come.
+	const char *start_price_stream(void** out, const char** tickers,
+		uint32_t ticker_count,
+		void (*on_tick)(void* data, uint32_t index, double price, int64_t time),
+		void (*on_end)(void* data, const char* error), void* data);
+	// optional, with start_price_stream: stops a stream and frees it. No
+	// callbacks are made once this returns. It is not locked for the
+	// plugin, even if the plugin is not thread safe.
+	void stop_price_stream(void* stream);
 	const char *get_position(Position* out, const char* ticker);
 	const char *get_account(Account* out);
+	// optional: returns non-zero if every function can be called from
+	// several threads at once. Otherwise calls are made one at a time.
+	uint32_t thread_safe();
 
 	// pre-defined functions
 	uint32_t key_count() { return KEY_COUNT; }
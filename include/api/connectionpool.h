@@ -0,0 +1,142 @@
+#ifndef DAYTRENDER_CONNECTION_POOL_H
+#define DAYTRENDER_CONNECTION_POOL_H
+
+// standard library
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// external libraries
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include <httplib.h>
+
+namespace daytrender
+{
+	/**
+	 * Keeps open connections to a host for client plugins. A connection is
+	 * leased for a request and then handed back with its TLS session still
+	 * open, so only the first request on it pays for the handshake. Every
+	 * lease has a connection of its own, so requests from several threads
+	 * do not wait on each other. A new connection is made when none are
+	 * idle and connections past max_idle are closed when they come back.
+	 */
+	class ConnectionPool
+	{
+	public:
+		typedef httplib::SSLClient Connection;
+		typedef std::function<void(Connection&)> Configure;
+
+		/**
+		 * Connection that goes back to its pool when it goes out of scope
+		 */
+		class Lease
+		{
+		private:
+			ConnectionPool *_pool;
+			unsigned _generation;
+			std::unique_ptr<Connection> _connection;
+
+		public:
+			Lease(ConnectionPool& pool, unsigned generation,
+				std::unique_ptr<Connection> connection) :
+			_pool(&pool),
+			_generation(generation),
+			_connection(std::move(connection))
+			{}
+
+			Lease(Lease&& other) = default;
+			Lease(const Lease& other) = delete;
+
+			~Lease()
+			{
+				if (_connection) _pool->release(_generation, std::move(_connection));
+			}
+
+			Lease& operator=(const Lease& other) = delete;
+
+			inline Connection *operator->() { return _connection.get(); }
+			inline Connection& operator*() { return *_connection; }
+		};
+
+	private:
+		std::string _host;
+		unsigned _max_idle;
+		Configure _configure;
+		// increases whenever the configuration changes
+		unsigned _generation = 0;
+		std::vector<std::unique_ptr<Connection>> _idle;
+		std::mutex _mtx;
+
+		void release(unsigned generation, std::unique_ptr<Connection> connection)
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+
+			// anything not kept is closed by the caller after the lock is gone
+			if (generation != _generation || _idle.size() >= _max_idle) return;
+
+			_idle.push_back(std::move(connection));
+		}
+
+	public:
+		ConnectionPool(const std::string& host, unsigned max_idle = 8) :
+		_host(host),
+		_max_idle(max_idle)
+		{}
+
+		ConnectionPool(const ConnectionPool& other) = delete;
+		ConnectionPool& operator=(const ConnectionPool& other) = delete;
+
+		/**
+		 * Sets what is done to every new connection, like setting the
+		 * credentials. The idle connections were made with the old one, so
+		 * they are closed.
+		 */
+		void configure(Configure configure)
+		{
+			std::vector<std::unique_ptr<Connection>> idle;
+			{
+				std::lock_guard<std::mutex> lock(_mtx);
+				_configure = std::move(configure);
+				_generation++;
+				idle.swap(_idle);
+			}
+		}
+
+		/**
+		 * Gets the connection that was used last or makes a new one. A
+		 * connection that was leased while the configuration changed is
+		 * not kept once it comes back.
+		 */
+		Lease acquire()
+		{
+			std::unique_lock<std::mutex> lock(_mtx);
+			unsigned generation = _generation;
+
+			if (!_idle.empty())
+			{
+				std::unique_ptr<Connection> connection = std::move(_idle.back());
+				_idle.pop_back();
+				return Lease(*this, generation, std::move(connection));
+			}
+
+			Configure configure = _configure;
+			lock.unlock();
+
+			auto connection = std::make_unique<Connection>(_host);
+			connection->set_keep_alive(true);
+			if (configure) configure(*connection);
+
+			return Lease(*this, generation, std::move(connection));
+		}
+
+		inline size_t idle_count()
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			return _idle.size();
+		}
+	};
+}
+
+#endif
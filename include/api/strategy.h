@@ -6,6 +6,7 @@
 #include <data/result.h>
 
 // standard library
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -28,6 +29,13 @@ namespace daytrender
 		int _indicator_count = 0;
 		int _data_length = 0;
 		const char *(*_execute)(Chart*) = nullptr;
+		const char *(*_execute_series)(Chart*, short*, uint32_t) = nullptr;
+		const char *(*_execute_batch)(Chart**, short**, uint32_t, uint32_t) = nullptr;
+		// incremental functions of api version 2
+		void *(*_create_state)(const uint32_t*, uint32_t) = nullptr;
+		void (*_destroy_state)(void*) = nullptr;
+		const char *(*_init)(void*, const PriceHistory*, short*) = nullptr;
+		const char *(*_on_candle)(void*, const Candle*, int64_t, short*) = nullptr;
 
 	public:
 		Strategy() = default;
@@ -35,11 +43,29 @@ namespace daytrender
 
 		Chart execute(const PriceHistory& candles,
 			const std::vector<unsigned>& ranges) const;
+		void execute(Chart& chart, const PriceHistory& candles,
+			const std::vector<unsigned>& ranges) const;
+
+		std::vector<short> execute_series(const PriceHistory& candles,
+			const std::vector<unsigned>& ranges, unsigned window) const;
+		void execute_series(Chart& chart, std::vector<short>& actions,
+			const PriceHistory& candles, const std::vector<unsigned>& ranges,
+			unsigned window) const;
+		void execute_batch(std::vector<Chart>& charts,
+			std::vector<std::vector<short>>& actions, const PriceHistory& candles,
+			const std::vector<std::vector<unsigned>>& ranges, unsigned window) const;
+
+		std::shared_ptr<void> create_state(const std::vector<unsigned>& ranges) const;
+		short init(void *state, const PriceHistory& history) const;
+		short on_candle(void *state, const Candle& candle, long long time) const;
 			
 		inline const std::string& filename() const { return _filename; };
 		inline int indicator_count() const { return _indicator_count; }
 		inline bool is_bound() const { return (bool)_plugin; }
 		inline int data_length() const { return _data_length; }
+		inline bool is_streamable() const { return _execute_series != nullptr; }
+		inline bool is_batchable() const { return _execute_batch != nullptr; }
+		inline bool is_incremental() const { return _on_candle != nullptr; }
 	};
 }
 
@@ -3,8 +3,10 @@
 #define STRATEGY_API_H
 
 #include <data/chart.h>
+#include <data/candlewindow.h>
 #include <api/versions.h>
 #include <api/action.h>
+#include <util/indicators.h>
 
 #ifndef LABEL
 #define LABEL
@@ -20,17 +22,100 @@ using namespace daytrender;
 
 #include <stdint.h>
 
+/**
+ * Indicator of the strategy. func can be one of the kernels in
+ * daytrender::indicators or a custom function with the same signature.
+ * Scratch memory for a custom indicator or for strategy() can be taken
+ * from Arena::local(), which is reset at the start of every execution.
+ *
+ * step is optional and is the incremental version of func, like the ones
+ * in daytrender::indicators::stream. If every indicator has one, the
+ * strategy can keep state for each asset and be fed one candle at a time
+ * through init() and on_candle() instead of being executed on every tick.
+ *
+ * batch is optional and is the version of func in
+ * daytrender::indicators::batch, used when backtesting many sets of
+ * ranges at once.
+ */
 struct IndicatorConfig
 {
 	void(*func)(Indicator&, const PriceHistory&, unsigned);
 	const char *type;
 	const char *label;
+	indicators::stream::Step step = nullptr;
+	indicators::batch::Kernel batch = nullptr;
 };
 
 //extern std::vector<indicator_conf> indi_confs;
 extern const std::vector<IndicatorConfig> config;
 
 Action strategy(const Chart& chart);
+
+/**
+ * State of the strategy for one asset. The chart holds the last
+ * DATA_LENGTH values of every indicator, the newest of which is for the
+ * pending candle: the newest candle fed, which may still change until a
+ * newer one arrives.
+ */
+struct StrategyState
+{
+	std::vector<unsigned> ranges;
+	std::vector<indicators::Stream> streams;
+	CandleWindow candles;
+	Chart chart;
+	Candle pending;
+	long long pending_time = 0;
+	bool started = false;
+};
+
+/**
+ * Adds a candle to the state. A candle that is newer than the pending one
+ * commits the pending one to the indicators first. Otherwise it replaces
+ * the pending one. Either way only the newest value of each indicator is
+ * calculated, so this takes the same time no matter how long the history
+ * is.
+ */
+static void feed(StrategyState& state, const Candle& candle, long long time)
+{
+	bool is_new = !state.started || time > state.pending_time;
+
+	for (size_t i = 0; i < config.size(); ++i)
+	{
+		indicators::Stream& stream = state.streams[i];
+		Indicator& ind = state.chart[i];
+		unsigned last = ind.size() - 1;
+
+		if (state.started && is_new)
+			config[i].step(stream, state.pending, true);
+
+		double value = config[i].step(stream, candle, false);
+
+		if (!state.started)
+		{
+			for (unsigned j = 0; j < ind.size(); ++j) ind[j] = value;
+		}
+		else if (is_new)
+		{
+			for (unsigned j = 0; j < last; ++j) ind[j] = ind[j + 1];
+		}
+
+		ind[last] = value;
+	}
+
+	if (is_new)
+	{
+		state.candles.push(candle, time);
+		state.pending_time = time;
+	}
+	else
+	{
+		state.candles.set_back(candle, state.pending_time);
+	}
+
+	state.chart.set_candles(state.candles.view());
+	state.pending = candle;
+	state.started = true;
+}
 // api interface
 extern "C"
 {
@@ -47,6 +132,7 @@ extern "C"
 	{
 		Chart &chart = *out;
 		chart.set_label(LABEL);
+		Arena::local().reset();
 
 		if (chart.candles().empty())
 			return "no candles were passed to strategy";
@@ -65,6 +151,253 @@ extern "C"
 
 		return NULL;
 	}
+
+	/**
+	 * Runs the strategy over an entire history in a single pass. The
+	 * indicators are calculated once over every candle and the strategy
+	 * is then evaluated on a sliding window of the chart, so each candle
+	 * only costs a call to strategy() instead of a full recalculation.
+	 * 
+	 * @param	out		chart whose indicators are the same size as its candles
+	 * @param	actions	buffer of size candles().size() that the action
+	 * 					taken at each candle is written to
+	 * @param	window	amount of candles visible to the strategy at a time
+	 */
+	const char *execute_series(Chart* out, short* actions, uint32_t window)
+	{
+		Chart &chart = *out;
+		chart.set_label(LABEL);
+		Arena& arena = Arena::local();
+		arena.reset();
+
+		const PriceHistory& candles = chart.candles();
+
+		if (candles.empty())
+			return "no candles were passed to strategy";
+
+		if (chart.ranges().size() != indicator_count())
+			return "strategy dataset size did not match expected sizse";
+
+		if (window == 0 || window > candles.size())
+			return "window was not within the bounds of the candles";
+
+		for (size_t i = 0; i < config.size(); ++i)
+		{
+			if (chart[i].size() != candles.size())
+				return "indicators were not the same size as the candles";
+
+			chart[i].set_ident(config[i].type, config[i].label);
+			config[i].func(chart[i], candles, chart.ranges()[i]);
+		}
+
+		for (uint32_t i = 0; i < window - 1; ++i)
+		{
+			actions[i] = NOTHING;
+		}
+
+		// one view is moved along the chart so no window allocates
+		Chart view(arena);
+		for (uint32_t i = window; i <= candles.size(); ++i)
+		{
+			chart.slice(i - window, window, view);
+			actions[i - 1] = strategy(view);
+		}
+
+		return NULL;
+	}
+
+	/**
+	 * Runs the strategy over an entire history for several sets of ranges,
+	 * like execute_series does for each one. Indicators with a batch
+	 * kernel are calculated for every set in one pass, and the strategy is
+	 * evaluated for every set at a candle before moving to the next.
+	 * 
+	 * @param	outs	charts of every set, all over the same candles
+	 * @param	actions	buffer of every set, like the one of execute_series
+	 * @param	count	amount of sets
+	 * @param	window	amount of candles visible to the strategy at a time
+	 */
+	const char *execute_batch(Chart** outs, short** actions, uint32_t count,
+		uint32_t window)
+	{
+		Arena& arena = Arena::local();
+		arena.reset();
+
+		if (count == 0) return NULL;
+
+		const PriceHistory& candles = outs[0]->candles();
+
+		if (candles.empty())
+			return "no candles were passed to strategy";
+
+		if (window == 0 || window > candles.size())
+			return "window was not within the bounds of the candles";
+
+		for (uint32_t c = 0; c < count; ++c)
+		{
+			Chart& chart = *outs[c];
+			chart.set_label(LABEL);
+
+			if (chart.ranges().size() != indicator_count())
+				return "strategy dataset size did not match expected sizse";
+
+			if (chart.candles().closes() != candles.closes()
+				|| chart.candles().size() != candles.size())
+				return "charts were not over the same candles";
+
+			for (size_t i = 0; i < config.size(); ++i)
+			{
+				if (chart[i].size() != candles.size())
+					return "indicators were not the same size as the candles";
+			}
+		}
+
+		Indicator **data = arena.allocate<Indicator*>(count);
+		unsigned *ranges = arena.allocate<unsigned>(count);
+
+		for (size_t i = 0; i < config.size(); ++i)
+		{
+			for (uint32_t c = 0; c < count; ++c)
+			{
+				Chart& chart = *outs[c];
+				chart[i].set_ident(config[i].type, config[i].label);
+				data[c] = &chart[i];
+				ranges[c] = chart.ranges()[i];
+			}
+
+			if (config[i].batch)
+			{
+				config[i].batch(data, candles, ranges, count);
+				continue;
+			}
+
+			for (uint32_t c = 0; c < count; ++c)
+			{
+				config[i].func(*data[c], candles, ranges[c]);
+			}
+		}
+
+		for (uint32_t c = 0; c < count; ++c)
+		{
+			for (uint32_t i = 0; i < window - 1; ++i)
+			{
+				actions[c][i] = NOTHING;
+			}
+		}
+
+		Chart view(arena);
+		for (uint32_t i = window; i <= candles.size(); ++i)
+		{
+			for (uint32_t c = 0; c < count; ++c)
+			{
+				outs[c]->slice(i - window, window, view);
+				actions[c][i - 1] = strategy(view);
+			}
+		}
+
+		return NULL;
+	}
+
+	/**
+	 * Creates the state of the strategy for one asset.
+	 * 
+	 * @return	the state, or NULL if some indicator has no step function or
+	 * 			the amount of ranges is wrong
+	 */
+	void *create_state(const uint32_t *ranges, uint32_t range_count)
+	{
+		if (range_count != indicator_count()) return NULL;
+
+		for (const IndicatorConfig& conf : config)
+		{
+			if (!conf.step) return NULL;
+		}
+
+		StrategyState *state = new StrategyState();
+		unsigned capacity = DATA_LENGTH;
+
+		state->ranges.assign(ranges, ranges + range_count);
+		state->streams.resize(range_count);
+
+		for (unsigned range : state->ranges)
+		{
+			if (range > capacity) capacity = range;
+		}
+
+		state->candles = CandleWindow(capacity, 0);
+		state->chart.reset(state->ranges, PriceHistory(), DATA_LENGTH);
+		state->chart.set_label(LABEL);
+
+		for (size_t i = 0; i < config.size(); ++i)
+		{
+			state->chart[i].set_ident(config[i].type, config[i].label);
+		}
+
+		return state;
+	}
+
+	void destroy_state(void *state)
+	{
+		delete (StrategyState*)state;
+	}
+
+	/**
+	 * Starts the state over from a history. This is the only call that
+	 * takes time proportional to the amount of candles.
+	 * 
+	 * @param	action	set to the action at the last candle of the history
+	 */
+	const char *init(void *ptr, const PriceHistory *history, short *action)
+	{
+		StrategyState &state = *(StrategyState*)ptr;
+		Arena::local().reset();
+
+		if (history->empty())
+			return "no candles were passed to strategy";
+
+		for (size_t i = 0; i < config.size(); ++i)
+		{
+			indicators::stream::reset(state.streams[i], state.ranges[i]);
+		}
+
+		state.candles = CandleWindow(state.candles.capacity(), history->interval());
+		state.started = false;
+
+		for (unsigned i = 0; i < history->size(); ++i)
+		{
+			feed(state, history->get(i), history->timestamp(i));
+		}
+
+		Action act = strategy(state.chart);
+		state.chart.set_action(act);
+		*action = act;
+
+		return NULL;
+	}
+
+	/**
+	 * Feeds the next candle to the state. A candle with the same
+	 * timestamp as the last one replaces it, like when a candle that had
+	 * not closed yet is fetched again.
+	 * 
+	 * @param	action	set to the action at the candle
+	 */
+	const char *on_candle(void *ptr, const Candle *candle, int64_t time, short *action)
+	{
+		StrategyState &state = *(StrategyState*)ptr;
+		Arena::local().reset();
+
+		if (!state.started)
+			return "state was not initialized with a history";
+
+		feed(state, *candle, time);
+
+		Action act = strategy(state.chart);
+		state.chart.set_action(act);
+		*action = act;
+
+		return NULL;
+	}
 	// pre-defined functions
 }
 
@@ -1,7 +1,12 @@
 #ifndef DAYTRENDER_API_VERSIONS_H
 #define DAYTRENDER_API_VERSIONS_H
 
-#define CLIENT_API_VERSION		1
-#define STRATEGY_API_VERSION	1
+#define CLIENT_API_VERSION		2
+#define STRATEGY_API_VERSION	2
+
+// plugins from before version 2 pass candles, indicators and charts with
+// their old memory layout, so they are not loaded
+#define MIN_CLIENT_API_VERSION		2
+#define MIN_STRATEGY_API_VERSION	2
 
 #endif
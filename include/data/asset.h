@@ -4,8 +4,10 @@
 // local includes
 #include <api/strategy.h>
 #include <data/candle.h>
+#include <data/candlewindow.h>
 
 // standard libarary
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,7 +27,13 @@ namespace daytrender
 		unsigned _candle_count = 0;
 		std::string _ticker;
 		Strategy _strategy;
+		// nothing is risked until walking forward has measured the edge of the strategy
 		double _risk = 0.0;
+		CandleWindow _candles;
+		Chart _chart;
+		// state of incremental strategies and the time of the last candle fed to it
+		std::shared_ptr<void> _state;
+		long long _state_time = 0;
 		
 	private: // initializer getters
 
@@ -34,7 +42,6 @@ namespace daytrender
 		Strategy get_strategy(const hirzel::Data& config, const std::string& dir) const;
 		std::string get_ticker(const hirzel::Data& config) const;
 		unsigned get_candle_count() const;
-		double get_risk() const;
 
 	
 	public: // public functions
@@ -42,15 +49,30 @@ namespace daytrender
 		Asset(const hirzel::Data& config, const std::string& dir);
 
 		unsigned update(const PriceHistory& hist);
+		unsigned update();
 		inline bool should_update() const
 		{
-			return hirzel::sys::epoch_seconds() - _last_update >= _interval;
+			return hirzel::sys::epoch_seconds() >= next_update();
 		}
 
+		/**
+		 * Epoch seconds at which the asset should next be updated: the
+		 * start of the candle after the one it was last updated during.
+		 */
+		inline long long next_update() const
+		{
+			return _last_update - _last_update % _interval + _interval;
+		}
+
+		inline void set_last_update(long long time) { _last_update = time; }
+		inline void set_risk(double risk) { _risk = risk; }
+
 		// inline getter functions
 		inline const Strategy& strategy() const { return _strategy; }
 		inline const std::string& ticker() const { return _ticker; }
 		inline const std::vector<unsigned>& ranges() const { return _ranges; }
+		inline const CandleWindow& candles() const { return _candles; }
+		inline CandleWindow& candles() { return _candles; }
 		inline unsigned interval() const { return _interval; }
 		inline unsigned candle_count() const { return _candle_count; }
 		inline double risk() const { return _risk; }
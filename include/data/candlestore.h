@@ -0,0 +1,82 @@
+#ifndef DAYTRENDER_CANDLESTORE_H
+#define DAYTRENDER_CANDLESTORE_H
+
+// local includes
+#include <data/pricehistory.h>
+
+// standard library
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace daytrender
+{
+	/**
+	 * Read-only memory mapping of the stored candles of one ticker and
+	 * interval. The history points straight into the mapped files, so it
+	 * is only valid for as long as the map is. A map never changes once it
+	 * is made; appending to the store creates a new one.
+	 */
+	class CandleMap
+	{
+	private:
+		void* _columns[6] = { nullptr };
+		size_t _bytes = 0;
+		PriceHistory _history;
+
+		void unmap();
+
+	public:
+		CandleMap(const std::string& path, unsigned interval);
+		CandleMap(const CandleMap& other) = delete;
+		~CandleMap();
+
+		CandleMap& operator=(const CandleMap& other) = delete;
+
+		inline const PriceHistory& history() const { return _history; }
+		inline unsigned size() const { return _history.size(); }
+		inline bool empty() const { return _history.empty(); }
+		inline long long last_timestamp() const
+		{
+			return empty() ? 0 : _history.timestamps()[size() - 1];
+		}
+	};
+
+	/**
+	 * On-disk candle history of a client. Every ticker and interval is a
+	 * folder of fixed-width column files (time, open, high, low, close and
+	 * volume), each a raw array of 8 byte values in candle order. New
+	 * candles are only ever appended to the end of them.
+	 */
+	class CandleStore
+	{
+	private:
+		std::string _dir;
+		std::mutex _mtx;
+		std::unordered_map<std::string, std::shared_ptr<const CandleMap>> _maps;
+
+		std::string get_path(const std::string& ticker, unsigned interval) const;
+		std::shared_ptr<const CandleMap> get_map(const std::string& path,
+			unsigned interval);
+		void write(const std::string& path, const PriceHistory& hist,
+			unsigned offset, bool append) const;
+
+	public:
+		CandleStore(const std::string& dir);
+		CandleStore(const CandleStore& other) = delete;
+
+		CandleStore& operator=(const CandleStore& other) = delete;
+
+		std::shared_ptr<const CandleMap> load(const std::string& ticker,
+			unsigned interval);
+		std::shared_ptr<const CandleMap> append(const std::string& ticker,
+			const PriceHistory& hist);
+		std::shared_ptr<const CandleMap> replace(const std::string& ticker,
+			const PriceHistory& hist);
+
+		inline const std::string& dir() const { return _dir; }
+	};
+}
+
+#endif
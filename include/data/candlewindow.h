@@ -0,0 +1,91 @@
+#ifndef DAYTRENDER_CANDLEWINDOW_H
+#define DAYTRENDER_CANDLEWINDOW_H
+
+// local includes
+#include <data/pricehistory.h>
+
+namespace daytrender
+{
+	/**
+	 * Fixed capacity window of the newest candles. It is a ring buffer
+	 * where every value is written twice, once in each half of its
+	 * columns, so that the window is always one contiguous run and can be
+	 * viewed as a PriceHistory without copying. Nothing is allocated after
+	 * construction.
+	 */
+	class CandleWindow
+	{
+	private:
+		double* _open = nullptr;
+		double* _high = nullptr;
+		double* _low = nullptr;
+		double* _close = nullptr;
+		double* _volume = nullptr;
+		long long* _time = nullptr;
+		unsigned _capacity = 0;
+		unsigned _interval = 0;
+		unsigned _next = 0;
+		unsigned _size = 0;
+		// candles are fetched into this before being pushed
+		PriceHistory _buffer;
+
+		void write(unsigned index, const Candle& candle, long long time);
+
+		inline unsigned first() const
+		{
+			return (_next + _capacity - _size) % _capacity;
+		}
+
+	public:
+		CandleWindow() = default;
+		CandleWindow(unsigned capacity, unsigned interval);
+		CandleWindow(const CandleWindow& other);
+		CandleWindow(CandleWindow&& other);
+		~CandleWindow();
+
+		CandleWindow& operator=(const CandleWindow& other);
+		CandleWindow& operator=(CandleWindow&& other);
+
+		void push(const Candle& candle, long long time);
+		void set_back(const Candle& candle, long long time);
+		void assign(const PriceHistory& hist);
+		bool tick(double price, long long time);
+		PriceHistory view() const;
+
+		inline void clear()
+		{
+			_next = 0;
+			_size = 0;
+		}
+
+		inline Candle get(unsigned index) const
+		{
+			if (index >= _size)
+				throw std::out_of_range("CandleWindow::get(): index is "
+					+ std::to_string(index)
+					+ " but size is "
+					+ std::to_string(_size));
+
+			unsigned i = first() + index;
+			return Candle(_open[i], _high[i], _low[i], _close[i], _volume[i]);
+		}
+
+		inline Candle operator[](unsigned index) const { return get(index); }
+		inline Candle back(unsigned index = 0) const { return get((_size - 1) - index); }
+		inline Candle front(unsigned index = 0) const { return get(index); }
+
+		inline long long back_timestamp() const
+		{
+			return _time[(_next + _capacity - 1) % _capacity];
+		}
+
+		inline PriceHistory& buffer() { return _buffer; }
+		inline bool empty() const { return _size == 0; }
+		inline bool full() const { return _size == _capacity; }
+		inline unsigned size() const { return _size; }
+		inline unsigned capacity() const { return _capacity; }
+		inline unsigned interval() const { return _interval; }
+	};
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <api/action.h>
 #include <data/pricehistory.h>
 #include <data/indicator.h>
+#include <util/arena.h>
 
 // standard library
 #include <vector>
@@ -20,16 +21,30 @@ namespace daytrender
 		const char* _label = nullptr;
 		std::vector<unsigned> _ranges;
 		PriceHistory _candles;
+		// charts made in an arena get their indicators from it
+		Arena* _arena = nullptr;
+
+		void allocate_dataset(short size);
+		void free_dataset();
 
 	public:
 		Chart() = default;
+		Chart(Arena& arena);
 		Chart(const std::vector<unsigned>& ranges, const PriceHistory& candles, unsigned window);
+		Chart(const std::vector<unsigned>& ranges, const PriceHistory& candles, unsigned window,
+			Arena& arena);
 		Chart(const Chart& other);
 		Chart(Chart&& other);
 
 		~Chart();
 
 		Chart& operator=(const Chart& other);
+		Chart slice(unsigned offset, unsigned size) const;
+		void slice(unsigned offset, unsigned size, Chart& out) const;
+		void reset(const std::vector<unsigned>& ranges, const PriceHistory& candles,
+			unsigned data_length);
+		void set_candles(const PriceHistory& candles);
+
 		inline Indicator& operator[](unsigned index) { return _dataset[index]; }
 		inline const Indicator& operator[](unsigned index) const { return _dataset[index]; }
 
@@ -40,6 +55,7 @@ namespace daytrender
 		inline const char* label() const { return _label; }
 		inline const PriceHistory& candles() const { return _candles; }
 		inline const std::vector<unsigned>& ranges() const { return _ranges; }
+		inline Arena* arena() const { return _arena; }
 		inline void increment_size() { _size++; }
 	};
 }
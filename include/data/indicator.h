@@ -1,5 +1,12 @@
 #pragma once
 
+// local includes
+#include <util/arena.h>
+
+// standard library
+#include <stdexcept>
+#include <string>
+
 namespace daytrender
 {
 	class Indicator
@@ -7,17 +14,30 @@ namespace daytrender
 	private:
 		double* _data = nullptr;
 		unsigned _size = 0;
+		unsigned _capacity = 0;
 		const char* _type = nullptr;
 		const char* _label = nullptr;
+		bool _slice = false;
+		// indicators made in an arena get their buffers from it
+		Arena* _arena = nullptr;
+
+		// constructor for making slices
+		Indicator(double* parent_data, const char* type, const char* label,
+			unsigned offset, unsigned size);
 
 	public:
 
 		Indicator() = default;
 		Indicator(unsigned size);
+		Indicator(unsigned size, Arena& arena);
 		Indicator(const Indicator& other);
 		Indicator(Indicator&& other);
 		~Indicator();
 		Indicator& operator=(const Indicator& other);
+		Indicator& operator=(Indicator&& other);
+
+		Indicator slice(unsigned offset, unsigned size) const;
+		void resize(unsigned size);
 		
 		inline double& operator[](unsigned pos) { return _data[pos]; }
 		inline double operator[](unsigned pos) const { return _data[pos]; }
@@ -31,5 +51,6 @@ namespace daytrender
 		}
 		inline const char* label() const { return _label; }
 		inline const char* type() const { return _type; }
+		inline bool is_slice() const { return _slice; }
 	};
-}
\ No newline at end of file
+}
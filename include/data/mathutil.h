@@ -1,3 +1,6 @@
+#ifndef DAYTRENDER_MATHUTIL_H
+#define DAYTRENDER_MATHUTIL_H
+
 #include <cmath>
 
 namespace daytrender
@@ -7,4 +10,6 @@ namespace daytrender
 	{
 		return std::floor(((buying_power / (1.0 + fee)) / price) / order_minimum) * order_minimum;
 	}
-}
\ No newline at end of file
+}
+
+#endif
@@ -24,7 +24,21 @@ namespace daytrender
 		double _leverage = 1.0;
 		double _margin_used = 0.0;
 		double _price_sum = 0.0;
-		std::vector<double> _return_history;
+
+		// running moments of the return of every trade
+		int _return_count = 0;
+		double _return_mean = 0.0;
+		double _return_m2 = 0.0;
+		double _downside_sum = 0.0;
+
+		// drawdown of the balance after every trade
+		double _peak_balance = 0.0;
+		double _max_drawdown = 0.0;
+
+		// positive for wins in a row and negative for losses in a row
+		int _streak = 0;
+		int _max_win_streak = 0;
+		int _max_loss_streak = 0;
 
 		bool _shorting_enabled = false;
 
@@ -49,6 +63,9 @@ namespace daytrender
 
 		std::vector<int> _ranges;
 
+		void record_return(double returns);
+		double risk_free_rate() const;
+
 	public:
 		PaperAccount() = default;
 		PaperAccount(double principal, int leverage, double fee, double order_minimum,
@@ -103,6 +120,11 @@ namespace daytrender
 		inline int short_exits() const { return _short_exits; }
 		inline int short_trades() const { return _short_entrances + _short_exits; }
 
+		inline int closed_trades() const { return _return_count; }
+		inline double max_drawdown() const { return _max_drawdown; }
+		inline int max_win_streak() const { return _max_win_streak; }
+		inline int max_loss_streak() const { return _max_loss_streak; }
+
 		inline int interval() const { return _interval; }
 		inline const std::vector<int>& ranges() const { return _ranges; };
 		
@@ -124,7 +146,9 @@ namespace daytrender
 		double pct_per_year() const;
 
 		double return_volatility() const;
+		double downside_deviation() const;
 		double sharpe_ratio() const;
+		double sortino_ratio() const;
 		double kelly_criterion() const;
 
 		double long_win_rate() const;
@@ -3,9 +3,14 @@
 
 // local includes
 #include <data/asset.h>
+#include <data/portfolioaccount.h>
+#include <data/result.h>
 #include <api/client.h>
+#include <interface/optimizer.h>
 
 //standard library
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -29,10 +34,13 @@ namespace daytrender
 		double _max_loss = 0.05;
 		unsigned _history_length = 0;
 		unsigned _closeout_buffer = 0;
+		WalkForwardConfig _walk_forward;
 		std::string _label;
 		Client _client;
 		std::vector<Asset> _assets;
 		std::vector<std::pair<long long, double>> _equity_history;
+		// held while the account is updated or an order is placed
+		std::shared_ptr<std::recursive_mutex> _mtx = std::make_shared<std::recursive_mutex>();
 
 	private: // initializer functions
 
@@ -41,6 +49,7 @@ namespace daytrender
 		double get_max_loss(const hirzel::Data& config) const;
 		double get_history_length(const hirzel::Data& config) const;
 		unsigned get_closeout_buffer(const hirzel::Data& config) const;
+		WalkForwardConfig get_walk_forward(const hirzel::Data& config) const;
 		Client get_client(const hirzel::Data& config,
 			const std::string& dir) const;
 		std::vector<Asset> get_assets(const hirzel::Data& config,
@@ -52,6 +61,11 @@ namespace daytrender
 
 		void update();
 		void update_assets();
+		void update_asset(Asset& asset);
+		void evaluate_asset(Asset& asset);
+		void take_action(Asset& asset, unsigned action);
+		void calibrate_risk(Optimizer& optimizer);
+		Result<PortfolioAccount> backtest();
 		
 		double risk_sum() const;
 
@@ -66,9 +80,15 @@ namespace daytrender
 		}
 
 		inline bool should_update() const
+		{
+			return hirzel::sys::epoch_seconds() >= next_update();
+		}
+
+		// epoch seconds at which the account should next be updated
+		inline long long next_update() const
 		{
 			// update once per minute
-			return hirzel::sys::epoch_seconds() - _last_update >= PORTFOLIO_UPDATE_INTERVAL;
+			return _last_update + PORTFOLIO_UPDATE_INTERVAL;
 		}
 
 		inline bool is_live() const
@@ -81,6 +101,11 @@ namespace daytrender
 			return _client;
 		}
 
+		inline std::vector<Asset>& assets()
+		{
+			return _assets;
+		}
+
 		inline std::string label() const
 		{
 			return _label;
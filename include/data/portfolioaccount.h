@@ -0,0 +1,109 @@
+#ifndef DAYTRENDER_PORTFOLIOACCOUNT_H
+#define DAYTRENDER_PORTFOLIOACCOUNT_H
+
+// standard library
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace daytrender
+{
+	/**
+	 * Paper account that every asset of a portfolio trades from. Orders
+	 * are sized the way Client::enter_position sizes live ones: each asset
+	 * gets its weight of the account's buying power and margin, less what
+	 * it already has invested. Equity is kept as a running sum so that
+	 * updating the price of one asset does not visit the others.
+	 */
+	class PortfolioAccount
+	{
+	private:
+		struct Holding
+		{
+			double fee = 0.0;
+			double order_minimum = 1.0;
+			double weight = 0.0;
+			double price = 0.0;
+			double shares = 0.0;
+			double margin_used = 0.0;
+		};
+
+		double _principal = 0.0;
+		double _balance = 0.0;
+		double _leverage = 1.0;
+		double _margin_used = 0.0;
+		// equity of the open positions
+		double _position_value = 0.0;
+		bool _shorting_enabled = false;
+
+		std::vector<Holding> _holdings;
+
+		int _entrances = 0;
+		int _exits = 0;
+		int _win_count = 0;
+		int _loss_count = 0;
+		double _profits = 0.0;
+		double _losses = 0.0;
+
+		double _peak_equity = 0.0;
+		double _max_drawdown = 0.0;
+
+		static inline double value(const Holding& h)
+		{
+			return h.shares * h.price + (h.shares >= 0.0 ? -h.margin_used : h.margin_used);
+		}
+
+		bool enter(unsigned index, double multiplier);
+		bool exit(Holding& h, double returns);
+
+	public:
+		PortfolioAccount() = default;
+		PortfolioAccount(double principal, double leverage, bool shorting_enabled);
+
+		unsigned add_asset(double fee, double order_minimum, double weight);
+
+		bool enter_long(unsigned index);
+		bool exit_long(unsigned index);
+		bool enter_short(unsigned index);
+		bool exit_short(unsigned index);
+		bool close_position(unsigned index);
+		bool close_all_positions();
+
+		void update_price(unsigned index, double price);
+		void record_equity();
+
+		inline double principal() const { return _principal; }
+		inline double balance() const { return _balance; }
+		inline double leverage() const { return _leverage; }
+		inline double margin_used() const { return _margin_used; }
+		inline bool shorting_enabled() const { return _shorting_enabled; }
+		inline unsigned size() const { return _holdings.size(); }
+
+		inline double shares(unsigned index) const { return _holdings[index].shares; }
+		inline double price(unsigned index) const { return _holdings[index].price; }
+		inline double weight(unsigned index) const { return _holdings[index].weight; }
+
+		inline int entrances() const { return _entrances; }
+		inline int exits() const { return _exits; }
+		inline double profits() const { return _profits; }
+		inline double losses() const { return _losses; }
+		inline double max_drawdown() const { return _max_drawdown; }
+
+		inline double equity() const { return _balance + _position_value; }
+		inline double buying_power() const
+		{
+			double bp = _balance * _leverage - _margin_used;
+			return (bp >= 0.0 ? bp : 0.0);
+		}
+
+		double net_return() const;
+		double pct_return() const;
+		double win_rate() const;
+		double profit_rate() const;
+
+		std::string to_string() const;
+		friend std::ostream& operator<<(std::ostream& out, const PortfolioAccount& acc);
+	};
+}
+
+#endif
@@ -3,69 +3,126 @@
 
 // local includes
 #include <data/candle.h>
+#include <util/arena.h>
+
+// standard library
+#include <stdexcept>
 
 
 namespace daytrender
 {
+	/**
+	 * History of candles stored by column. Each of the open, high, low,
+	 * close, volume and timestamp series is its own contiguous array so
+	 * that indicators only stream through the values they use.
+	 */
 	class PriceHistory
 	{
 	private:
-		Candle* _data = nullptr;
+		double* _open = nullptr;
+		double* _high = nullptr;
+		double* _low = nullptr;
+		double* _close = nullptr;
+		double* _volume = nullptr;
+		long long* _time = nullptr;
 		unsigned _size = 0;
 		unsigned _interval = 0;
 		bool _slice = false;
 
 		// constructor for making slices
-		PriceHistory(Candle* parent_data, unsigned parent_size,
-			unsigned parent_interval, unsigned offset, unsigned size);
+		PriceHistory(const PriceHistory& parent, unsigned offset, unsigned size);
+
+		void allocate(unsigned size);
+		void allocate(unsigned size, Arena& arena);
+		void deallocate();
+
+		inline void check_index(unsigned index) const
+		{
+			if (index >= _size)
+				throw std::out_of_range("PriceHistory::get(): index is "
+					+ std::to_string(index)
+					+ " but size is "
+					+ std::to_string(_size));
+		}
 
 	public:
 		PriceHistory() = default;
 		PriceHistory(unsigned size, unsigned interval);
+		PriceHistory(unsigned size, unsigned interval, Arena& arena);
+		PriceHistory(double* open, double* high, double* low, double* close,
+			double* volume, long long* time, unsigned size, unsigned interval);
 		PriceHistory(PriceHistory&& other);
 		PriceHistory(const PriceHistory& other);
 
 		~PriceHistory();
 
 		PriceHistory& operator=(const PriceHistory& other);
+		PriceHistory& operator=(PriceHistory&& other);
 		PriceHistory slice(unsigned offset, unsigned size) const;
 
-		inline Candle& get(unsigned index)
+		inline Candle get(unsigned index) const
 		{
-			if (index >= _size)
-				throw std::out_of_range("PriceHistory::get(): index is "
-					+ std::to_string(index)
-					+ " but size is "
-					+ std::to_string(_size));
-
-			return _data[index];
+			check_index(index);
+			return Candle(_open[index], _high[index], _low[index],
+				_close[index], _volume[index]);
 		}
 
-		inline const Candle& get(unsigned index) const
+		inline void set(unsigned index, const Candle& candle)
 		{
-			return get(index);
+			check_index(index);
+			_open[index] = candle.open();
+			_high[index] = candle.high();
+			_low[index] = candle.low();
+			_close[index] = candle.close();
+			_volume[index] = candle.volume();
 		}
 
-		inline Candle& operator[](int index)
+		inline void set(unsigned index, const Candle& candle, long long time)
 		{
-			return get(index);
+			set(index, candle);
+			_time[index] = time;
 		}
 
-		inline const Candle& operator[] (unsigned index) const
+		void set(unsigned index, const PriceHistory& other, unsigned offset,
+			unsigned count);
+
+		inline Candle operator[](unsigned index) const
 		{
 			return get(index);
 		}
 
-		inline const Candle& back(unsigned index = 0) const
+		inline Candle back(unsigned index = 0) const
 		{
 			return get((_size - 1) - index);
 		}
 
-		inline const Candle& front(unsigned index = 0) const
+		inline Candle front(unsigned index = 0) const
 		{
 			return get(index);
 		}
 
+		// column access
+
+		inline const double* opens() const { return _open; }
+		inline const double* highs() const { return _high; }
+		inline const double* lows() const { return _low; }
+		inline const double* closes() const { return _close; }
+		inline const double* volumes() const { return _volume; }
+		inline const long long* timestamps() const { return _time; }
+
+		inline double* opens() { return _open; }
+		inline double* highs() { return _high; }
+		inline double* lows() { return _low; }
+		inline double* closes() { return _close; }
+		inline double* volumes() { return _volume; }
+		inline long long* timestamps() { return _time; }
+
+		inline long long timestamp(unsigned index) const
+		{
+			check_index(index);
+			return _time[index];
+		}
+
 		inline bool is_slice() const { return _slice; }
 		inline bool empty() const { return _size == 0; }
 		inline unsigned size() const { return _size; }
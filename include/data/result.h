@@ -1,71 +1,113 @@
 #ifndef HIRZEL_RESULT_H
 #define HIRZEL_RESULT_H
 
+#include <new>
 #include <utility>
 
 namespace daytrender
 {
+	/**
+	 * Value or error of a function that can fail. The value is stored in
+	 * the result itself, so making one does not allocate, and it can be
+	 * moved out with get() instead of being copied.
+	 */
 	template <typename T>
 	class Result
 	{
 	private:
-		bool _ok = false;
-
 		union
 		{
-			const char *error = nullptr;
-			T *value;
-		} _data;
+			T _value;
+		};
 
-	public:
-		Result(T&& value)
-		{
-			_ok = true;
-			_data.value = new T(value);
-		}
+		const char *_error = nullptr;
+		bool _ok;
 
-		Result(Result&& other)
+		void construct(const Result& other)
 		{
-			_ok = other._ok;
-			_data = other._data;
-			other._ok = false;
+			// a value that fails to construct is not destroyed
+			_ok = false;
+
+			if (other._ok)
+			{
+				new (&_value) T(other._value);
+				_ok = true;
+			}
+			else
+			{
+				_error = other._error;
+			}
 		}
 
-		Result(const Result& other)
+		void construct(Result&& other)
 		{
-			*this = other;
+			_ok = false;
+
+			if (other._ok)
+			{
+				new (&_value) T(std::move(other._value));
+				_ok = true;
+			}
+			else
+			{
+				_error = other._error;
+			}
 		}
 
-		Result(const char *error)
+		void destroy()
 		{
-			_data.error = error;
+			if (_ok) _value.~T();
 		}
 
-		~Result()
+	public:
+		Result(const T& value) :
+		_value(value),
+		_ok(true)
+		{}
+
+		Result(T&& value) :
+		_value(std::move(value)),
+		_ok(true)
+		{}
+
+		Result(const char *error) :
+		_error(error),
+		_ok(false)
+		{}
+
+		Result(const Result& other) { construct(other); }
+		Result(Result&& other) { construct(std::move(other)); }
+		~Result() { destroy(); }
+
+		/**
+		 * Moves the value out of the result. The result still holds the
+		 * moved from value afterwards.
+		 */
+		inline T&& get() { return std::move(_value); }
+
+		inline T& value() { return _value; }
+		inline const T& value() const { return _value; }
+		inline const char* error() const { return _error; }
+		inline bool ok() const { return _ok; }
+
+		Result& operator=(const Result& other)
 		{
-			if (_ok) delete _data.value;
+			if (this == &other) return *this;
+
+			destroy();
+			construct(other);
+
+			return *this;
 		}
 
-		inline T&& get()
+		Result& operator=(Result&& other)
 		{
-			return std::move(*_data.value);
-		}
+			if (this == &other) return *this;
 
-		inline T value() { return _data.value; }
-		inline const char* error() { return _data.error; }
-		inline bool ok() { return _ok; }
+			destroy();
+			construct(std::move(other));
 
-		Result& operator=(const Result& other)
-		{
-			_ok = other.ok();
-			if (_ok)
-			{
-				_data.value = other.get();
-			}
-			else
-			{
-				_data.error = other.error();
-			}
+			return *this;
 		}
 
 		inline operator bool() const { return _ok; }
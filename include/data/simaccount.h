@@ -0,0 +1,144 @@
+#ifndef DAYTRENDER_SIMACCOUNT_H
+#define DAYTRENDER_SIMACCOUNT_H
+
+// local includes
+#include <data/mathutil.h>
+
+// standard library
+#include <type_traits>
+
+namespace daytrender
+{
+	/**
+	 * Settings that every account of a sweep shares
+	 */
+	struct SimConfig
+	{
+		double principal = 0.0;
+		double leverage = 1.0;
+		double fee = 0.0;
+		double order_minimum = 1.0;
+		bool shorting_enabled = false;
+	};
+
+	/**
+	 * Account for ranking many permutations of a backtest. It simulates
+	 * orders the same way as PaperAccount but only keeps what is needed for
+	 * that and for the return it is ranked by. It is trivially copyable and
+	 * never allocates, so the accounts of a sweep can be kept in one array.
+	 * The full statistics of the best ones are found by backtesting them
+	 * again with a PaperAccount.
+	 *
+	 * The config must outlive the account.
+	 */
+	class SimAccount
+	{
+	private:
+		const SimConfig *_config = nullptr;
+		double _balance = 0.0;
+		double _price = 0.0;
+		double _shares = 0.0;
+		double _margin_used = 0.0;
+		unsigned _trades = 0;
+		bool _failed = false;
+
+	public:
+		SimAccount() = default;
+		SimAccount(const SimConfig& config, double initial_price) :
+		_config(&config),
+		_balance(config.principal),
+		_price(initial_price)
+		{}
+
+		inline void update_price(double price) { _price = price; }
+
+		bool enter_long()
+		{
+			if (_shares < 0.0 && !exit_short()) return false;
+
+			double shares = get_shares_to_order(buying_power(), _price,
+				_config->order_minimum, _config->fee);
+			_margin_used += shares * _price * (1.0 + _config->fee);
+			_shares += shares;
+
+			return true;
+		}
+
+		bool exit_long()
+		{
+			if (_shares <= 0.0) return true;
+
+			_balance += (_shares * _price * (1.0 - _config->fee)) - _margin_used;
+			_margin_used = 0.0;
+			_shares = 0.0;
+			_trades++;
+
+			return _balance >= 0.0;
+		}
+
+		bool enter_short()
+		{
+			if (_shares > 0.0 && !exit_long()) return false;
+			if (!_config->shorting_enabled) return true;
+
+			double shares = get_shares_to_order(buying_power(), _price,
+				_config->order_minimum, _config->fee);
+			_margin_used += shares * _price * (1.0 + _config->fee);
+			_shares -= shares;
+
+			return true;
+		}
+
+		bool exit_short()
+		{
+			if (_shares >= 0.0) return true;
+
+			_balance += _margin_used + (_shares * _price * (1.0 + _config->fee));
+			_margin_used = 0.0;
+			_shares = 0.0;
+			_trades++;
+
+			return _balance >= 0.0;
+		}
+
+		inline bool close_position()
+		{
+			if (_shares > 0.0) return exit_long();
+			if (_shares < 0.0) return exit_short();
+			return true;
+		}
+
+		inline const SimConfig& config() const { return *_config; }
+		inline double balance() const { return _balance; }
+		inline double price() const { return _price; }
+		inline double shares() const { return _shares; }
+		inline unsigned trades() const { return _trades; }
+
+		// marks the account as one whose backtest did not finish
+		inline void fail() { _failed = true; }
+		inline bool failed() const { return _failed; }
+
+		inline double equity() const
+		{
+			return _balance + _shares * _price + (_shares >= 0.0 ? -_margin_used : _margin_used);
+		}
+
+		inline double buying_power() const
+		{
+			double bp = _balance * _config->leverage - _margin_used;
+			return (bp >= 0.0 ? bp : 0.0);
+		}
+
+		inline double net_return() const { return equity() - _config->principal; }
+
+		inline double pct_return() const
+		{
+			return (_config->principal > 0.0) ? net_return() / _config->principal : 0.0;
+		}
+	};
+
+	static_assert(std::is_trivially_copyable<SimAccount>::value,
+		"sim accounts must be trivially copyable");
+}
+
+#endif
@@ -9,8 +9,13 @@
 
 // local includes
 #include <data/portfolio.h>
+#include <util/scheduler.h>
+#include <util/threadpool.h>
 
 // standard library
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -20,15 +25,32 @@ namespace daytrender
 	class TradeSystem
 	{
 	private:
-		bool _running = false;
+		std::atomic<bool> _running = false;
 		bool _initialized = false;
 		std::mutex _mtx;
 		std::vector<Portfolio> _portfolios;
+		Scheduler _scheduler;
+		// candle batches that are being fetched and have not called back yet
+		unsigned _batches = 0;
+		std::mutex _batch_mtx;
+		std::condition_variable _batch_cv;
+		// updates that are due run here so that they do not wait on each other
+		ThreadPool _pool;
+		// price streams of the portfolios that stream instead of polling,
+		// only used by the thread in start()
+		std::vector<std::shared_ptr<void>> _streams;
 
 		bool init(const std::string& dir);
+		void schedule_portfolio(Portfolio& portfolio, long long when);
+		void schedule_asset(Portfolio& portfolio, Asset& asset, long long when);
+		void schedule_assets(Portfolio& portfolio, std::vector<Asset*> assets,
+			long long when);
+		void schedule_polling(Portfolio& portfolio, long long when);
+		void schedule_report(long long when);
+		bool start_stream(Portfolio& portfolio);
 
 	public:
-		TradeSystem(const std::string& dir);
+		TradeSystem(const std::string& dir, unsigned thread_count = 0);
 
 		void start();
 
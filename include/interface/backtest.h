@@ -6,6 +6,8 @@
 #include <api/strategy.h>
 #include <data/asset.h>
 #include <data/paperaccount.h>
+#include <data/portfolioaccount.h>
+#include <data/simaccount.h>
 
 // standard library
 #include <vector>
@@ -13,6 +15,43 @@
 
 namespace daytrender
 {
+	bool backtest_permutation(PaperAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window);
+	bool backtest_permutation(PaperAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window,
+		Chart& chart, std::vector<short>& actions);
+	bool backtest_permutation(SimAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window,
+		Chart& chart, std::vector<short>& actions);
+
+	bool backtest_actions(PaperAccount& acc, const PriceHistory& candles,
+		const short *actions, unsigned first, unsigned last);
+	bool backtest_actions(SimAccount& acc, const PriceHistory& candles,
+		const short *actions, unsigned first, unsigned last);
+	bool backtest_batch(std::vector<SimAccount>& accounts, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<std::vector<unsigned>>& ranges,
+		unsigned window, std::vector<Chart>& charts,
+		std::vector<std::vector<short>>& actions);
+
+	/**
+	 * Candles of one asset of a portfolio backtest and the strategy that
+	 * trades them. The candles must be in time order and outlive the
+	 * backtest.
+	 */
+	struct PortfolioSeries
+	{
+		const Strategy *strat = nullptr;
+		std::vector<unsigned> ranges;
+		const PriceHistory *candles = nullptr;
+		unsigned window = 0;
+	};
+
+	bool backtest_portfolio(PortfolioAccount& acc,
+		const std::vector<PortfolioSeries>& series);
+
+	std::vector<unsigned> best_accounts(const std::vector<SimAccount>& accounts,
+		unsigned count);
+
 	namespace interface
 	{
 		std::vector<PaperAccount> backtest(int strat_index, int asset_index, double principal,
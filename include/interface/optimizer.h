@@ -0,0 +1,93 @@
+#ifndef DAYTRENDER_OPTIMIZER_H
+#define DAYTRENDER_OPTIMIZER_H
+
+// local includes
+#include <api/strategy.h>
+#include <data/paperaccount.h>
+#include <data/pricehistory.h>
+#include <data/simaccount.h>
+#include <util/threadpool.h>
+
+// standard library
+#include <vector>
+
+namespace daytrender
+{
+	enum Metric
+	{
+		NET_RETURN,
+		PCT_RETURN,
+		PCT_PER_YEAR,
+		SHARPE_RATIO,
+		KELLY_CRITERION,
+		WIN_RATE,
+		PROFIT_RATE
+	};
+
+	double get_metric(const PaperAccount& acc, Metric metric);
+
+	/**
+	 * How ranges are searched and how a history is split when walking
+	 * forward. Every step optimizes on in_sample candles and is scored on
+	 * the out_of_sample candles after them, and the next step starts
+	 * out_of_sample candles later.
+	 */
+	struct WalkForwardConfig
+	{
+		unsigned min_range = 0;
+		unsigned max_range = 0;
+		unsigned granularity = 1;
+		unsigned in_sample = 0;
+		unsigned out_of_sample = 0;
+	};
+
+	struct WalkForwardStep
+	{
+		// first in sample candle
+		unsigned start;
+		// first out of sample candle
+		unsigned split;
+		// candle after the last out of sample one
+		unsigned end;
+		// best ranges in sample
+		std::vector<unsigned> ranges;
+		double in_sample_return;
+		double out_of_sample_return;
+	};
+
+	struct WalkForward
+	{
+		std::vector<WalkForwardStep> steps;
+		// trades of every out of sample window one after the other
+		PaperAccount account;
+
+		double risk() const;
+	};
+
+	/**
+	 * Grid searches the ranges of a strategy by backtesting every
+	 * permutation of them on a pool of threads.
+	 */
+	class Optimizer
+	{
+	private:
+		ThreadPool _pool;
+
+	public:
+		Optimizer(unsigned thread_count = 0);
+
+		std::vector<PaperAccount> optimize(const Strategy& strategy,
+			const PriceHistory& candles, double principal, int leverage,
+			double fee, double order_minimum, bool shorting_enabled,
+			unsigned min_range, unsigned max_range, unsigned granularity,
+			Metric metric, unsigned top_k);
+
+		WalkForward walk_forward(const Strategy& strategy,
+			const PriceHistory& candles, const SimConfig& account,
+			const WalkForwardConfig& config);
+
+		inline unsigned thread_count() const { return _pool.size(); }
+	};
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef DAYTRENDER_ARENA_H
+#define DAYTRENDER_ARENA_H
+
+// standard library
+#include <cstddef>
+#include <vector>
+
+namespace daytrender
+{
+	/**
+	 * Bump allocator for scratch memory. Allocations are carved out of large
+	 * blocks and are never freed one at a time; instead the arena is rewound
+	 * to an earlier mark or reset as a whole. Nothing that is constructed in
+	 * an arena has its destructor called by it, so only trivially
+	 * destructible data or objects that know they do not own their memory
+	 * should be put in one.
+	 *
+	 * An arena is not thread safe. Every thread has its own in local().
+	 */
+	class Arena
+	{
+	public:
+		struct Mark
+		{
+			size_t block;
+			size_t used;
+		};
+
+		/**
+		 * Rewinds the arena to where it was when the scope was made, so
+		 * everything allocated during the scope is released together.
+		 */
+		class Scope
+		{
+		private:
+			Arena& _arena;
+			Mark _mark;
+
+		public:
+			Scope(Arena& arena) :
+			_arena(arena),
+			_mark(arena.mark())
+			{}
+
+			Scope(const Scope& other) = delete;
+			~Scope() { _arena.rewind(_mark); }
+
+			Scope& operator=(const Scope& other) = delete;
+		};
+
+	private:
+		struct Block
+		{
+			char* data;
+			size_t size;
+		};
+
+		std::vector<Block> _blocks;
+		size_t _block_size;
+		size_t _current = 0;
+		size_t _used = 0;
+
+		void add_block(size_t size);
+
+	public:
+		Arena(size_t block_size = 1 << 16);
+		Arena(const Arena& other) = delete;
+		~Arena();
+
+		Arena& operator=(const Arena& other) = delete;
+
+		void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+		void rewind(const Mark& mark);
+		void reset();
+		size_t capacity() const;
+
+		template <typename T>
+		inline T* allocate(size_t count)
+		{
+			return (T*)allocate(count * sizeof(T), alignof(T));
+		}
+
+		inline Mark mark() const { return { _current, _used }; }
+
+		static Arena& local();
+	};
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef DAYTRENDER_INDICATORS_H
+#define DAYTRENDER_INDICATORS_H
+
+// local includes
+#include <data/indicator.h>
+#include <data/pricehistory.h>
+
+// standard library
+#include <vector>
+
+namespace daytrender
+{
+	/**
+	 * Built-in indicator kernels. Each one matches the signature of
+	 * IndicatorConfig::func so strategies can list them directly in their
+	 * config. The indicator lines up with the end of the candles, and any
+	 * window that would reach before the first candle is cut short. The
+	 * element-wise parts run on the fastest instruction set in vectorops.
+	 */
+	namespace indicators
+	{
+		// moving averages of close
+		void sma(Indicator& data, const PriceHistory& candles, unsigned range);
+		void ema(Indicator& data, const PriceHistory& candles, unsigned range);
+		void wma(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// Wilder's relative strength index of close, from 0 to 100
+		void rsi(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// ema(range) - ema(range * 26 / 12) of close
+		void macd(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// sma of close plus/minus two standard deviations
+		void bollinger_upper(Indicator& data, const PriceHistory& candles, unsigned range);
+		void bollinger_lower(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// Wilder's average true range
+		void atr(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// stochastic %K: where close sits between the lowest low and highest high
+		void stochastic(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		// lowest and highest close in the window
+		void rolling_min(Indicator& data, const PriceHistory& candles, unsigned range);
+		void rolling_max(Indicator& data, const PriceHistory& candles, unsigned range);
+
+		/**
+		 * Candles that can still be the lowest or highest of a window,
+		 * kept in a ring from oldest to newest.
+		 */
+		struct Extremes
+		{
+			std::vector<unsigned long long> index;
+			std::vector<double> value;
+			unsigned head = 0;
+			unsigned size = 0;
+		};
+
+		/**
+		 * Running state of an indicator that is fed one candle at a time.
+		 * What each field holds depends on the kernel that uses it.
+		 */
+		struct Stream
+		{
+			unsigned range = 1;
+			// amount of candles that have been committed
+			unsigned long long count = 0;
+			double value = 0.0;
+			double other = 0.0;
+			double square = 0.0;
+			double prev = 0.0;
+			double origin = 0.0;
+			// the last range inputs, by count % range
+			std::vector<double> window;
+			Extremes lowest;
+			Extremes highest;
+		};
+
+		/**
+		 * Incremental versions of the kernels above. Each gives the value of
+		 * the indicator at a candle that follows the committed ones, in
+		 * constant time. The candle is only added to the stream when commit
+		 * is set, so a candle that has not closed yet can be evaluated again
+		 * every time it changes. Fed every candle of a history in order,
+		 * they give the same values as the kernels above do on all of it.
+		 */
+		namespace stream
+		{
+			typedef double (*Step)(Stream& stream, const Candle& candle, bool commit);
+
+			// clears a stream and sizes its buffers for range
+			void reset(Stream& stream, unsigned range);
+
+			double sma(Stream& stream, const Candle& candle, bool commit);
+			double ema(Stream& stream, const Candle& candle, bool commit);
+			double wma(Stream& stream, const Candle& candle, bool commit);
+			double rsi(Stream& stream, const Candle& candle, bool commit);
+			double macd(Stream& stream, const Candle& candle, bool commit);
+			double bollinger_upper(Stream& stream, const Candle& candle, bool commit);
+			double bollinger_lower(Stream& stream, const Candle& candle, bool commit);
+			double atr(Stream& stream, const Candle& candle, bool commit);
+			double stochastic(Stream& stream, const Candle& candle, bool commit);
+			double rolling_min(Stream& stream, const Candle& candle, bool commit);
+			double rolling_max(Stream& stream, const Candle& candle, bool commit);
+		}
+
+		/**
+		 * Versions of the kernels above that calculate an indicator for
+		 * several ranges in one pass over the candles. Every candle is read
+		 * once for all of them and the ranges are updated side by side, so
+		 * sweeping ranges uses vector instructions instead of waiting on
+		 * the previous value of each one. Each indicator is filled as the
+		 * kernel above would fill it with its range.
+		 */
+		namespace batch
+		{
+			typedef void (*Kernel)(Indicator** data, const PriceHistory& candles,
+				const unsigned* ranges, unsigned count);
+
+			void ema(Indicator** data, const PriceHistory& candles,
+				const unsigned* ranges, unsigned count);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef DAYTRENDER_LATENCY_H
+#define DAYTRENDER_LATENCY_H
+
+// standard library
+#include <chrono>
+#include <string>
+
+namespace daytrender
+{
+	/**
+	 * Latency histograms of the stages of a live update. Every thread
+	 * records into histograms of its own without locking, and reading a
+	 * summary adds up those of every thread. Values are kept in buckets
+	 * that are at most 1/16 of their value wide, so percentiles are
+	 * within about 6% and recording is a few relaxed stores.
+	 */
+	namespace latency
+	{
+		enum Stage
+		{
+			// getting candles from the broker
+			FETCH,
+			// running a strategy
+			EXECUTE,
+			// placing an order
+			ORDER,
+			// updating the account of a portfolio
+			PORTFOLIO_UPDATE,
+			STAGE_COUNT
+		};
+
+		// nanoseconds
+		struct Summary
+		{
+			unsigned long long count;
+			unsigned long long mean;
+			unsigned long long p50;
+			unsigned long long p99;
+			unsigned long long max;
+		};
+
+		typedef std::chrono::steady_clock Clock;
+
+		void record(Stage stage, unsigned long long nanoseconds);
+		Summary summary(Stage stage);
+		const char *name(Stage stage);
+		std::string report();
+
+		inline void record(Stage stage, Clock::time_point start)
+		{
+			record(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(
+				Clock::now() - start).count());
+		}
+
+		/**
+		 * Records the time from its construction to the end of its scope
+		 */
+		class Timer
+		{
+		private:
+			Stage _stage;
+			Clock::time_point _start;
+
+		public:
+			Timer(Stage stage) :
+			_stage(stage),
+			_start(Clock::now())
+			{}
+
+			Timer(const Timer& other) = delete;
+			~Timer() { record(_stage, _start); }
+
+			Timer& operator=(const Timer& other) = delete;
+		};
+	}
+}
+
+#endif
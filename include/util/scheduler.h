@@ -0,0 +1,65 @@
+#ifndef DAYTRENDER_SCHEDULER_H
+#define DAYTRENDER_SCHEDULER_H
+
+// standard library
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace daytrender
+{
+	/**
+	 * Runs tasks at the times they are due. Tasks are kept in a min-heap by
+	 * deadline, and the thread in run() sleeps until the earliest one is
+	 * due or until an earlier one is scheduled. Tasks that are due at the
+	 * same time run in the order they were scheduled.
+	 */
+	class Scheduler
+	{
+	public:
+		typedef std::chrono::system_clock Clock;
+
+	private:
+		struct Entry
+		{
+			Clock::time_point when;
+			unsigned long long order;
+			std::function<void()> task;
+		};
+
+		std::vector<Entry> _heap;
+		unsigned long long _order = 0;
+		std::atomic<bool> _stopped = false;
+		std::mutex _mtx;
+		std::condition_variable _cv;
+
+		static bool later(const Entry& a, const Entry& b);
+
+	public:
+		Scheduler() = default;
+		Scheduler(const Scheduler& other) = delete;
+
+		Scheduler& operator=(const Scheduler& other) = delete;
+
+		void schedule(Clock::time_point when, std::function<void()> task);
+		void run();
+		void stop();
+
+		inline void schedule(long long epoch_seconds, std::function<void()> task)
+		{
+			schedule(Clock::time_point(std::chrono::seconds(epoch_seconds)),
+				std::move(task));
+		}
+
+		inline size_t size()
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			return _heap.size();
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef DAYTRENDER_THREADPOOL_H
+#define DAYTRENDER_THREADPOOL_H
+
+// standard library
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace daytrender
+{
+	/**
+	 * Fixed size pool of worker threads. Every worker has its own queue of
+	 * tasks that it takes from the back of and, once empty, it steals from
+	 * the front of the other workers' queues.
+	 */
+	class ThreadPool
+	{
+	private:
+		struct Queue
+		{
+			std::mutex mtx;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		static thread_local const ThreadPool *_worker_pool;
+		static thread_local unsigned _worker_index;
+
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _threads;
+		std::atomic<unsigned> _next_queue = 0;
+		std::atomic<unsigned> _queued = 0;
+		std::atomic<unsigned> _unfinished = 0;
+		bool _running = true;
+		std::mutex _mtx;
+		std::condition_variable _task_cv;
+		std::condition_variable _done_cv;
+
+		bool pop(unsigned index, std::function<void()>& task);
+		void work(unsigned index);
+
+	public:
+		ThreadPool(unsigned thread_count = 0);
+		ThreadPool(const ThreadPool& other) = delete;
+		~ThreadPool();
+
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+
+		void push(std::function<void()> task);
+		void wait();
+
+		inline unsigned size() const { return _threads.size(); }
+	};
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef DAYTRENDER_VECTOROPS_H
+#define DAYTRENDER_VECTOROPS_H
+
+namespace daytrender
+{
+	/**
+	 * Element-wise operations over arrays of doubles. Each has an AVX2,
+	 * SSE2 and scalar version, and the fastest one the cpu supports is
+	 * chosen the first time any of them is used. Outputs may alias inputs.
+	 */
+	namespace vectorops
+	{
+		// out[i] = (a[i] - b[i]) * scale + shift
+		void scaled_diff(const double* a, const double* b, double scale,
+			double shift, double* out, unsigned n);
+
+		// out[i] = a[i] + b[i] * scale
+		void add_scaled(const double* a, const double* b, double scale,
+			double* out, unsigned n);
+
+		// out[i] = min(a[i], b[i])
+		void min(const double* a, const double* b, double* out, unsigned n);
+
+		// out[i] = max(a[i], b[i])
+		void max(const double* a, const double* b, double* out, unsigned n);
+
+		// out[i] = max(high[i] - low[i], |high[i] - prev[i]|, |low[i] - prev[i]|)
+		void true_range(const double* high, const double* low,
+			const double* prev, double* out, unsigned n);
+
+		// out[i] = (x[i] - lo[i]) / (hi[i] - lo[i]) * scale, or 0 when hi == lo
+		void normalize(const double* x, const double* lo, const double* hi,
+			double scale, double* out, unsigned n);
+
+		// out[i] = sqrt(max(mean_sq[i] - mean[i]^2, 0))
+		void stddev(const double* mean, const double* mean_sq, double* out,
+			unsigned n);
+
+		// name of the instruction set in use: "avx2", "sse2" or "scalar"
+		const char *isa();
+	}
+}
+
+#endif
@@ -3,6 +3,8 @@
 // local includes
 #include <api/versions.h>
 #include <data/mathutil.h>
+#include <util/arena.h>
+#include <util/latency.h>
 
 // standard library
 #include <cstring>
@@ -15,16 +17,21 @@
 
 
 #define CLIENT_DIR "/clients/"
+#define CANDLE_DIR "/candles/"
 
 using namespace hirzel;
 
 namespace daytrender
 {
 	std::unordered_map<std::string, std::shared_ptr<Plugin>> Client::_plugins;
+	std::unordered_map<std::string, std::shared_ptr<CandleStore>> Client::_stores;
+	std::unordered_map<std::string, std::shared_ptr<std::mutex>> Client::_locks;
 
 	Client::Client(const hirzel::Data& config, const std::string& dir) :
 		_filename(get_filename(config)),
-		_plugin(get_plugin(config, dir))
+		_plugin(get_plugin(config, dir)),
+		_store(get_store(dir)),
+		_lock(get_lock())
 	{
 		if (!config.is_table())
 			throw std::invalid_argument("Portolio: 'client' must be an object");
@@ -56,6 +63,8 @@ namespace daytrender
 			
 			keys_arr.push_back(key.to_string());
 		}
+
+		if (_plugin) bind_functions();
 	}
 
 	std::string Client::get_filename(const Data& config) const
@@ -71,54 +80,56 @@ namespace daytrender
 		return filename.to_string();
 	}
 
+	/**
+	 * Gets the plugin of the client, binding it the first time it is used.
+	 * Clients of the same plugin share it. The plugin is null if it could
+	 * not be bound, which every call into it checks for.
+	 */
 	std::shared_ptr<hirzel::Plugin> Client::get_plugin(const Data& config,
 		const std::string& dir) const
 	{
-		
-	}
+		std::shared_ptr<Plugin>& cached = _plugins[_filename];
+		if (cached) return cached;
 
-	Client::Client(const std::string& filename, const std::string& dir) :
-		_filename(filename)
-	{
-		// get plugin
-		_plugin = _plugins[filename];
-		// if the plugin is not already cached, attempt to cache it
-		if (!_plugin)
+		std::string plugin_dir = dir + CLIENT_DIR + _filename;
+		DEBUG(plugin_dir);
+		auto plugin = std::make_shared<Plugin>();
+		
+		if (!plugin->bind(plugin_dir))
 		{
-			std::string plugin_dir = dir + CLIENT_DIR + filename;
-			DEBUG(plugin_dir);
-			_plugin = std::make_shared<Plugin>();
-			
-			if (!_plugin->bind(plugin_dir))
-			{
-				ERROR(_plugin->error());
-				_plugin.reset();
-				return;
-			}
+			ERROR(plugin->error());
+			return nullptr;
+		}
 
-			if (!_plugin->bind_functions({
-				"init",
-				"api_version",
-				"get_price_history",
-				"get_account",
-				"get_position",
-				"market_order",
-				"secs_till_market_close",
-				"set_leverage",
-				"to_interval",
-				"key_count",
-				"max_candles"
-			}))
-			{
-				ERROR(_plugin->error());
-				_plugin.reset();
-				return;
-			}
-			// cache plugin
-			_plugins[filename] = _plugin;
+		if (!plugin->bind_functions({
+			"init",
+			"api_version",
+			"get_price_history",
+			"get_account",
+			"get_position",
+			"market_order",
+			"secs_till_market_close",
+			"set_leverage",
+			"to_interval",
+			"key_count",
+			"max_candles"
+		}))
+		{
+			ERROR(plugin->error());
+			return nullptr;
 		}
 
-		// point functions
+		cached = plugin;
+		return plugin;
+	}
+
+	/**
+	 * Points the functions of the client at its plugin. Functions that
+	 * only newer plugins have are left null if the plugin does not have
+	 * them, which turns off what they are used for.
+	 */
+	void Client::bind_functions()
+	{
 		_init = (decltype(_init))_plugin->get_function("init");
 		_market_order = (decltype(_market_order))_plugin->get_function("market_order");
 		_set_leverage = (decltype(_set_leverage))_plugin->get_function("set_leverage");
@@ -131,6 +142,53 @@ namespace daytrender
 		_api_version = (decltype(_api_version))_plugin->get_function("api_version");
 		_key_count = (decltype(_key_count))_plugin->get_function("key_count");
 		_max_candles = (decltype(_max_candles))_plugin->get_function("max_candles");
+
+		// the rest of the functions are optional
+		if (_plugin->bind_function("get_price_history_since"))
+			_get_price_history_since = (decltype(_get_price_history_since))_plugin->get_function("get_price_history_since");
+
+		if (_plugin->bind_function("get_price_histories_since"))
+		{
+			_get_price_histories_since = (decltype(_get_price_histories_since))_plugin->get_function("get_price_histories_since");
+
+			if (_plugin->bind_function("get_price_histories_since_async"))
+				_get_price_histories_since_async = (decltype(_get_price_histories_since_async))_plugin->get_function("get_price_histories_since_async");
+		}
+
+		if (_plugin->bind_function("start_price_stream")
+			&& _plugin->bind_function("stop_price_stream"))
+		{
+			_start_price_stream = (decltype(_start_price_stream))_plugin->get_function("start_price_stream");
+			_stop_price_stream = (decltype(_stop_price_stream))_plugin->get_function("stop_price_stream");
+		}
+	}
+
+	std::shared_ptr<CandleStore> Client::get_store(const std::string& dir) const
+	{
+		// clients of the same plugin share a store
+		std::shared_ptr<CandleStore>& store = _stores[_filename];
+		if (!store) store = std::make_shared<CandleStore>(dir + CANDLE_DIR + _filename);
+		return store;
+	}
+
+	/**
+	 * Gets the lock that serializes calls into the plugin. Clients of the
+	 * same plugin share it since they share its global state. Plugins that
+	 * say they are thread safe do not get one.
+	 */
+	std::shared_ptr<std::mutex> Client::get_lock() const
+	{
+		if (!_plugin) return nullptr;
+
+		if (_plugin->bind_function("thread_safe"))
+		{
+			auto thread_safe = (uint32_t(*)())_plugin->get_function("thread_safe");
+			if (thread_safe()) return nullptr;
+		}
+
+		std::shared_ptr<std::mutex>& lock = _locks[_filename];
+		if (!lock) lock = std::make_shared<std::mutex>();
+		return lock;
 	}
 
 	const char *Client::init(const hirzel::Data& keys)
@@ -138,30 +196,104 @@ namespace daytrender
 		unsigned keyc = key_count();
 		if (keyc != keys.size()) return nullptr;
 
-		char **key_arr = new char*[keyc];
+		Arena& arena = Arena::local();
+		Arena::Scope scope(arena);
+
+		char **key_arr = arena.allocate<char*>(keyc);
 
 		for (unsigned i = 0; i < keys.size(); i++)
 		{
 			const std::string& str = keys[i].to_string();
-			key_arr[i] = new char[str.size() + 1];
+			key_arr[i] = arena.allocate<char>(str.size() + 1);
 			strcpy(key_arr[i], str.c_str());
 		}
 
-		const char *error = _init((const char**)key_arr);
-
-		for (unsigned i = 0; i< keyc; ++i) delete[] key_arr[i];
-		delete[] key_arr;
-
-		return error;
+		auto lock = lock_plugin();
+		return _init((const char**)key_arr);
 	}
 
 	const char *Client::set_leverage(unsigned leverage)
 	{
 		cli_func_check();
+		auto lock = lock_plugin();
 		return _set_leverage(leverage);
 	}
 
 
+	const char *Client::fetch_price_history(PriceHistory& out,
+		const std::string& ticker, unsigned interval, unsigned count) const
+	{
+		out = PriceHistory(count, interval);
+		latency::Timer timer(latency::FETCH);
+		auto lock = lock_plugin();
+		return _get_price_history(&out, ticker.c_str());
+	}
+
+	/**
+	 * Brings the stored candles of a ticker up to date. Only the candles
+	 * since the last stored one are fetched from the broker, unless the
+	 * store is empty, too short or cannot be continued, in which case it
+	 * is replaced with the latest count candles.
+	 *
+	 * @param	map		set to the store after it is updated
+	 * @param	fetched	set to the candles that were fetched
+	 * @param	closed	set to the amount of fetched candles that have
+	 * 					closed. Only these are stored.
+	 * @return			error from the broker or nullptr
+	 */
+	const char *Client::sync_price_history(std::shared_ptr<const CandleMap>& map,
+		PriceHistory& fetched, unsigned& closed, const std::string& ticker,
+		unsigned interval, unsigned count) const
+	{
+		if (interval == 0) return "interval must be above 0";
+
+		map = _store->load(ticker, interval);
+
+		long long now = sys::epoch_seconds();
+		long long last = map->last_timestamp();
+		unsigned fetch_count = count;
+
+		if (map->size() >= count)
+		{
+			// one extra so the fetched candles overlap with the store
+			long long missing = (now - last) / interval + 1;
+			if (missing < 1) missing = 1;
+			if (missing > max_candles()) missing = max_candles();
+			fetch_count = missing;
+		}
+
+		const char *error = fetch_price_history(fetched, ticker, interval, fetch_count);
+		if (error) return error;
+
+		// candles are missing between the end of the store and the fetched ones
+		bool gap = map->empty() || fetched.timestamp(0) > last;
+
+		if (gap && fetch_count < count)
+		{
+			error = fetch_price_history(fetched, ticker, interval, count);
+			if (error) return error;
+		}
+
+		// the newest candle can still change until its interval is over
+		closed = fetched.size();
+		while (closed > 0 && fetched.timestamp(closed - 1) + interval > now) closed--;
+
+		if (closed == 0) return nullptr;
+
+		PriceHistory complete = fetched.slice(0, closed);
+		map = gap
+			? _store->replace(ticker, complete)
+			: _store->append(ticker, complete);
+
+		return nullptr;
+	}
+
+	/**
+	 * Gets the latest candles of a ticker. Closed candles come from the
+	 * local candle store, which is first updated with whatever is missing
+	 * from its end. If the store fails, the candles come straight from the
+	 * broker.
+	 */
 	Result<PriceHistory> Client::get_price_history(const std::string& ticker,
 		unsigned interval, unsigned count) const
 	{
@@ -175,16 +307,418 @@ namespace daytrender
 		{
 			return "requested more candles than maximum";
 		}
-		PriceHistory hist(count, interval);
-		const char *error = _get_price_history(&hist, ticker.c_str());
+
+		if (_store)
+		{
+			try
+			{
+				std::shared_ptr<const CandleMap> map;
+				PriceHistory fetched;
+				unsigned closed = 0;
+
+				const char *error = sync_price_history(map, fetched, closed, ticker,
+					interval, count);
+				if (error) return error;
+
+				unsigned open = fetched.size() - closed;
+
+				// stored candles followed by the ones that are still open
+				if (map->size() + open >= count)
+				{
+					unsigned stored = count - open;
+					PriceHistory hist(count, interval);
+					hist.set(0, map->history(), map->size() - stored, stored);
+					hist.set(stored, fetched, closed, open);
+					return hist;
+				}
+
+				if (fetched.size() >= count)
+				{
+					PriceHistory hist(count, interval);
+					hist.set(0, fetched, fetched.size() - count, count);
+					return hist;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				WARNING("%s: candle store failed for $%s: %s", _filename, ticker, e.what());
+			}
+		}
+
+		PriceHistory hist;
+		const char *error = fetch_price_history(hist, ticker, interval, count);
 		if (error) return error;
 		return hist;
 	}
 
+	/**
+	 * Gets every stored candle of a ticker after bringing the store up to
+	 * date. The history is memory mapped and is not copied, so it stays
+	 * valid for as long as the returned map is held.
+	 */
+	Result<std::shared_ptr<const CandleMap>> Client::get_stored_history(
+		const std::string& ticker, unsigned interval) const
+	{
+		cli_func_check();
+
+		if (!_store) return "client does not have a candle store";
+
+		try
+		{
+			std::shared_ptr<const CandleMap> map;
+			PriceHistory fetched;
+			unsigned closed = 0;
+
+			const char *error = sync_price_history(map, fetched, closed, ticker,
+				interval, max_candles());
+			if (error) return error;
+
+			return map;
+		}
+		catch (const std::exception& e)
+		{
+			ERROR("%s: candle store failed for $%s: %s", _filename, ticker, e.what());
+			return "failed to load candle store";
+		}
+	}
+
+	/**
+	 * Brings a window of candles up to date. Only the candles from the
+	 * newest one in the window onward are fetched, into the window's own
+	 * buffer, and then pushed onto it. The newest candle is fetched again
+	 * since it may not have closed when it was last fetched. Windows that
+	 * are not full yet, and plugins that cannot fetch by time, get a full
+	 * history instead.
+	 *
+	 * @param	window	candles to update in place
+	 * @param	ticker	ticker the candles are for
+	 * @return			error or nullptr
+	 */
+	const char *Client::update_price_history(CandleWindow& window,
+		const std::string& ticker) const
+	{
+		cli_func_check();
+
+		if (!window.full() || !_get_price_history_since)
+		{
+			Result<PriceHistory> res = get_price_history(ticker, window.interval(),
+				window.capacity());
+			if (!res) return res.error();
+			window.assign(res.get());
+			return nullptr;
+		}
+
+		long long since = window.back_timestamp();
+		PriceHistory& fetched = window.buffer();
+		uint32_t fetched_count = 0;
+
+		const char *error;
+		{
+			latency::Timer timer(latency::FETCH);
+			auto lock = lock_plugin();
+			error = _get_price_history_since(&fetched, &fetched_count,
+				ticker.c_str(), since);
+		}
+		if (error) return error;
+
+		return push_fetched(window, since, fetched_count);
+	}
+
+	/**
+	 * Pushes the candles that were fetched into the buffer of a window onto
+	 * it. The one at since replaces the newest candle of the window.
+	 */
+	const char *Client::push_fetched(CandleWindow& window, long long since,
+		uint32_t count) const
+	{
+		PriceHistory& fetched = window.buffer();
+
+		if (count > fetched.size()) return "received more candles than requested";
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			long long time = fetched.timestamp(i);
+
+			if (time > since)
+			{
+				window.push(fetched[i], time);
+			}
+			else if (time == since)
+			{
+				window.set_back(fetched[i], time);
+			}
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * Request for the candles of several assets at once. The arrays after
+	 * requested are what is passed to the plugin and have one element for
+	 * every asset in the request.
+	 */
+	struct Client::Batch
+	{
+		const Client *client;
+		std::vector<Asset*> assets;
+		// error of every asset
+		std::vector<const char*> results;
+		// index in assets of every asset in the request
+		std::vector<unsigned> requested;
+		std::vector<PriceHistory*> outs;
+		std::vector<uint32_t> counts;
+		std::vector<const char*> tickers;
+		std::vector<int64_t> since;
+		std::vector<const char*> errors;
+		UpdateCallback done;
+		// when the asynchronous request was made
+		latency::Clock::time_point start;
+	};
+
+	/**
+	 * Sets up the request for a batch. Assets whose windows are not full
+	 * cannot be fetched by time, so they are updated on their own right
+	 * away, as is every asset if the plugin cannot batch.
+	 */
+	std::unique_ptr<Client::Batch> Client::make_batch(
+		const std::vector<Asset*>& assets) const
+	{
+		auto batch = std::make_unique<Batch>();
+
+		batch->client = this;
+		batch->assets = assets;
+		batch->results.resize(assets.size(), nullptr);
+
+		for (unsigned i = 0; i < assets.size(); ++i)
+		{
+			Asset& asset = *assets[i];
+			CandleWindow& window = asset.candles();
+
+			if (!_get_price_histories_since || !window.full())
+			{
+				batch->results[i] = update_price_history(asset);
+				continue;
+			}
+
+			batch->requested.push_back(i);
+			batch->outs.push_back(&window.buffer());
+			batch->counts.push_back(0);
+			batch->tickers.push_back(asset.ticker().c_str());
+			batch->since.push_back(window.back_timestamp());
+			batch->errors.push_back(nullptr);
+		}
+
+		return batch;
+	}
+
+	const char *Client::fetch_batch(Batch& batch) const
+	{
+		latency::Timer timer(latency::FETCH);
+		auto lock = lock_plugin();
+		return _get_price_histories_since(batch.outs.data(), batch.counts.data(),
+			batch.tickers.data(), batch.since.data(), batch.errors.data(),
+			batch.requested.size());
+	}
+
+	/**
+	 * Pushes the candles of a finished request onto the windows. A ticker
+	 * that failed on its own, or whose candles do not reach back to the
+	 * newest one of its window, is fetched again by itself. If the whole
+	 * request failed, every ticker in it gets the error.
+	 */
+	void Client::finish_batch(Batch& batch, const char *error) const
+	{
+		for (unsigned j = 0; j < batch.requested.size(); ++j)
+		{
+			unsigned i = batch.requested[j];
+			Asset& asset = *batch.assets[i];
+
+			if (error)
+			{
+				batch.results[i] = error;
+				continue;
+			}
+
+			const PriceHistory& fetched = *batch.outs[j];
+			uint32_t count = batch.counts[j];
+
+			if (batch.errors[j] || count == 0 || fetched.timestamp(0) > batch.since[j])
+			{
+				batch.results[i] = update_price_history(asset);
+				continue;
+			}
+
+			batch.results[i] = push_fetched(asset.candles(), batch.since[j], count);
+		}
+	}
+
+	// called by the plugin once an asynchronous request is over
+	void Client::finish_async(void *data, const char *error)
+	{
+		std::unique_ptr<Batch> batch((Batch*)data);
+		latency::record(latency::FETCH, batch->start);
+		batch->client->finish_batch(*batch, error);
+		batch->done(batch->results);
+	}
+
+	/**
+	 * Brings the windows of several assets up to date with as few requests
+	 * as possible. Plugins that can fetch many tickers at once get a single
+	 * request for every asset whose window is full. Every other asset is
+	 * updated on its own like in update_price_history().
+	 *
+	 * @param	assets	assets whose candles are updated in place
+	 * @return			error of every asset or nullptr if it was updated
+	 */
+	std::vector<const char*> Client::update_price_histories(
+		const std::vector<Asset*>& assets) const
+	{
+		if (!_plugin) return std::vector<const char*>(assets.size(), "client is not bound");
+
+		std::unique_ptr<Batch> batch = make_batch(assets);
+
+		if (!batch->requested.empty()) finish_batch(*batch, fetch_batch(*batch));
+
+		return std::move(batch->results);
+	}
+
+	/**
+	 * Like update_price_histories(), but it does not wait for the request
+	 * if the plugin can make it asynchronously. done is then called from a
+	 * thread of the plugin. Otherwise it is called before this returns.
+	 * The assets must not be changed or updated elsewhere until then.
+	 *
+	 * @param	assets	assets whose candles are updated in place
+	 * @param	done	receives the error of every asset
+	 */
+	void Client::update_price_histories_async(const std::vector<Asset*>& assets,
+		UpdateCallback done) const
+	{
+		if (!_plugin)
+		{
+			done(std::vector<const char*>(assets.size(), "client is not bound"));
+			return;
+		}
+
+		std::unique_ptr<Batch> batch = make_batch(assets);
+
+		if (batch->requested.empty())
+		{
+			done(batch->results);
+			return;
+		}
+
+		if (!_get_price_histories_since_async)
+		{
+			finish_batch(*batch, fetch_batch(*batch));
+			done(batch->results);
+			return;
+		}
+
+		batch->done = std::move(done);
+		batch->start = latency::Clock::now();
+
+		// the plugin owns the batch until it calls finish_async
+		Batch *data = batch.release();
+		const char *error;
+		{
+			auto lock = lock_plugin();
+			error = _get_price_histories_since_async(data->outs.data(),
+				data->counts.data(), data->tickers.data(), data->since.data(),
+				data->errors.data(), data->requested.size(), finish_async, data);
+		}
+
+		if (error)
+		{
+			batch.reset(data);
+			finish_batch(*batch, error);
+			batch->done(batch->results);
+		}
+	}
+
+	/**
+	 * Price stream of a plugin and the callbacks it calls. The tickers are
+	 * kept since the plugin may hold on to them.
+	 */
+	struct Client::Stream
+	{
+		std::shared_ptr<hirzel::Plugin> plugin;
+		void (*stop)(void*);
+		void *handle = nullptr;
+		std::vector<std::string> tickers;
+		std::vector<const char*> ticker_ptrs;
+		TickCallback on_tick;
+		StreamEndCallback on_end;
+	};
+
+	void Client::receive_tick(void *data, uint32_t index, double price,
+		int64_t time)
+	{
+		Stream& stream = *(Stream*)data;
+		if (index < stream.tickers.size()) stream.on_tick(index, price, time);
+	}
+
+	void Client::receive_stream_end(void *data, const char *error)
+	{
+		((Stream*)data)->on_end(error);
+	}
+
+	/**
+	 * Starts streaming the prices of tickers from the broker. The stream
+	 * runs until the returned handle is released, which waits for the
+	 * callbacks to be over, or until it fails and on_end is called. The
+	 * callbacks are called from a thread of the plugin, one at a time.
+	 *
+	 * @param	tickers	tickers to get the prices of
+	 * @param	on_tick	receives every price with the index of its ticker
+	 * @param	on_end	receives the error if the stream fails
+	 * @return			handle of the stream or error
+	 */
+	Result<std::shared_ptr<void>> Client::stream_prices(
+		const std::vector<std::string>& tickers, TickCallback on_tick,
+		StreamEndCallback on_end) const
+	{
+		cli_func_check();
+
+		if (!_start_price_stream) return "client cannot stream prices";
+
+		auto stream = std::make_unique<Stream>();
+
+		stream->plugin = _plugin;
+		stream->stop = _stop_price_stream;
+		stream->tickers = tickers;
+		stream->on_tick = std::move(on_tick);
+		stream->on_end = std::move(on_end);
+
+		for (const std::string& ticker : stream->tickers)
+		{
+			stream->ticker_ptrs.push_back(ticker.c_str());
+		}
+
+		const char *error;
+		{
+			auto lock = lock_plugin();
+			error = _start_price_stream(&stream->handle, stream->ticker_ptrs.data(),
+				stream->ticker_ptrs.size(), receive_tick, receive_stream_end,
+				stream.get());
+		}
+		if (error) return error;
+
+		// not locked since it waits for the callbacks, which may call the plugin
+		std::shared_ptr<void> handle(stream.release(), [](Stream *stream)
+		{
+			stream->stop(stream->handle);
+			delete stream;
+		});
+
+		return handle;
+	}
+
 	Result<Account> Client::get_account() const
 	{
 		cli_func_check();
 		Account account;
+		auto lock = lock_plugin();
 		const char *error = _get_account(&account);
 		if (error) return error;
 		return account;
@@ -204,6 +738,8 @@ namespace daytrender
 	{
 		cli_func_check();
 		if (amount == 0.0) return nullptr;
+		latency::Timer timer(latency::ORDER);
+		auto lock = lock_plugin();
 		return _market_order(ticker.c_str(), amount);
 	}
 
@@ -212,6 +748,7 @@ namespace daytrender
 		cli_func_check();
 
 		Position position;
+		auto lock = lock_plugin();
 		const char *error = _get_position(&position, ticker.c_str());
 		if (error) return error;
 		return position;
@@ -299,4 +836,4 @@ namespace daytrender
 		// exit position
 		return market_order(asset.ticker(), -pos.shares());
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -51,15 +51,33 @@ namespace daytrender
 		}
 
 		int api_version = _plugin->execute<int>("api_version");
-		if (api_version != STRATEGY_API_VERSION)
+		if (api_version < MIN_STRATEGY_API_VERSION || api_version > STRATEGY_API_VERSION)
 		{
-			ERROR("%s: api version (%d) did not match current api version: %d)", _filename, api_version, STRATEGY_API_VERSION);
+			ERROR("%s: api version (%d) is not supported by current api version: %d)", _filename, api_version, STRATEGY_API_VERSION);
 			return;
 		}
 
 		_indicator_count = _plugin->execute<uint32_t>("indicator_count");
 		_data_length = _plugin->execute<uint32_t>("data_length");
 		_execute = (decltype(_execute))_plugin->get_function("execute");
+
+		// the rest of the functions are optional
+		if (_plugin->bind_function("execute_series"))
+			_execute_series = (decltype(_execute_series))_plugin->get_function("execute_series");
+
+		if (_plugin->bind_function("execute_batch"))
+			_execute_batch = (decltype(_execute_batch))_plugin->get_function("execute_batch");
+
+		if (_plugin->bind_function("create_state")
+			&& _plugin->bind_function("destroy_state")
+			&& _plugin->bind_function("init")
+			&& _plugin->bind_function("on_candle"))
+		{
+			_create_state = (decltype(_create_state))_plugin->get_function("create_state");
+			_destroy_state = (decltype(_destroy_state))_plugin->get_function("destroy_state");
+			_init = (decltype(_init))_plugin->get_function("init");
+			_on_candle = (decltype(_on_candle))_plugin->get_function("on_candle");
+		}
 	}
 
 
@@ -84,4 +102,186 @@ namespace daytrender
 
 		return data;
 	}
+
+	/**
+	 * Executes the strategy into an existing chart, which is reset in place
+	 * instead of being reallocated. The chart only views the candles, so
+	 * they must outlive it.
+	 */
+	void Strategy::execute(Chart& chart, const PriceHistory& candles,
+		const std::vector<unsigned>& ranges) const
+	{
+		if (!_execute) throw _filename + ": execute function is not bound";
+
+		chart.reset(ranges, candles, _data_length);
+
+		const char *error = _execute(&chart);
+
+		if (error) throw _filename + ": " + std::string(error);
+	}
+
+	std::vector<short> Strategy::execute_series(const PriceHistory& candles,
+		const std::vector<unsigned>& ranges, unsigned window) const
+	{
+		Chart chart;
+		std::vector<short> actions;
+
+		execute_series(chart, actions, candles, ranges, window);
+
+		return actions;
+	}
+
+	/**
+	 * Gets the action the strategy would take at every candle of a history.
+	 * If the plugin exports execute_series, the indicators are only
+	 * calculated once for the whole history. Otherwise, the strategy is
+	 * executed on every window of the history as it would be live.
+	 * 
+	 * @param	chart	workspace that is reused between calls
+	 * @param	actions	set to the action taken at each candle, NOTHING
+	 * 					until the first full window
+	 * @param	candles	full history to run the strategy over
+	 * @param	ranges	ranges of the indicators
+	 * @param	window	amount of candles the strategy sees at a time
+	 */
+	void Strategy::execute_series(Chart& chart, std::vector<short>& actions,
+		const PriceHistory& candles, const std::vector<unsigned>& ranges,
+		unsigned window) const
+	{
+		if (!_execute) throw _filename + ": execute function is not bound";
+		if (window == 0 || window > candles.size())
+			throw _filename + ": window is not within the bounds of the candles";
+
+		actions.assign(candles.size(), NOTHING);
+
+		if (_execute_series)
+		{
+			// indicators span the entire history
+			chart.reset(ranges, candles, candles.size());
+			const char *error = _execute_series(&chart, actions.data(), window);
+
+			if (error) throw _filename + ": " + std::string(error);
+
+			return;
+		}
+
+		for (unsigned i = window; i <= candles.size(); ++i)
+		{
+			execute(chart, candles.slice(i - window, window), ranges);
+			actions[i - 1] = chart.action();
+		}
+	}
+
+	/**
+	 * Gets the actions of several sets of ranges over the same history. If
+	 * the plugin exports execute_batch, every set is run in one pass over
+	 * the candles. Otherwise each set is run with execute_series.
+	 * 
+	 * @param	charts	workspace of every set that is reused between calls
+	 * @param	actions	set to the actions of every set
+	 * @param	candles	full history to run the strategy over
+	 * @param	ranges	ranges of the indicators of every set
+	 * @param	window	amount of candles the strategy sees at a time
+	 */
+	void Strategy::execute_batch(std::vector<Chart>& charts,
+		std::vector<std::vector<short>>& actions, const PriceHistory& candles,
+		const std::vector<std::vector<unsigned>>& ranges, unsigned window) const
+	{
+		if (!_execute) throw _filename + ": execute function is not bound";
+		if (window == 0 || window > candles.size())
+			throw _filename + ": window is not within the bounds of the candles";
+
+		charts.resize(ranges.size());
+		actions.resize(ranges.size());
+
+		if (!_execute_batch)
+		{
+			for (size_t i = 0; i < ranges.size(); ++i)
+			{
+				execute_series(charts[i], actions[i], candles, ranges[i], window);
+			}
+
+			return;
+		}
+
+		std::vector<Chart*> outs(ranges.size());
+		std::vector<short*> buffers(ranges.size());
+
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			// indicators span the entire history
+			charts[i].reset(ranges[i], candles, candles.size());
+			actions[i].assign(candles.size(), NOTHING);
+			outs[i] = &charts[i];
+			buffers[i] = actions[i].data();
+		}
+
+		const char *error = _execute_batch(outs.data(), buffers.data(),
+			outs.size(), window);
+
+		if (error) throw _filename + ": " + std::string(error);
+	}
+
+	/**
+	 * Creates the state that the plugin keeps for one asset. It is
+	 * destroyed by the plugin when the last copy of the pointer is gone.
+	 * 
+	 * @param	ranges	ranges of the indicators
+	 * @return			state, or null if the strategy is not incremental
+	 */
+	std::shared_ptr<void> Strategy::create_state(const std::vector<unsigned>& ranges) const
+	{
+		if (!_create_state) return nullptr;
+
+		std::vector<uint32_t> ranges32(ranges.begin(), ranges.end());
+		void *state = _create_state(ranges32.data(), ranges32.size());
+
+		if (!state) return nullptr;
+
+		// holding the plugin so that it is not unloaded before the state is destroyed
+		auto destroy = _destroy_state;
+		std::shared_ptr<hirzel::Plugin> plugin = _plugin;
+
+		return std::shared_ptr<void>(state, [destroy, plugin](void *ptr)
+		{
+			destroy(ptr);
+		});
+	}
+
+	/**
+	 * Starts a state over from a history. This takes time proportional to
+	 * the history, so it should only be done once per asset or when the
+	 * candles it was fed can no longer be continued.
+	 * 
+	 * @return	action at the last candle of the history
+	 */
+	short Strategy::init(void *state, const PriceHistory& history) const
+	{
+		if (!_init) throw _filename + ": init function is not bound";
+
+		short action = NOTHING;
+		const char *error = _init(state, &history, &action);
+
+		if (error) throw _filename + ": " + std::string(error);
+
+		return action;
+	}
+
+	/**
+	 * Feeds a candle to a state that was started with init(). A candle with
+	 * the same timestamp as the last one replaces it.
+	 * 
+	 * @return	action at the candle
+	 */
+	short Strategy::on_candle(void *state, const Candle& candle, long long time) const
+	{
+		if (!_on_candle) throw _filename + ": on_candle function is not bound";
+
+		short action = NOTHING;
+		const char *error = _on_candle(state, &candle, time, &action);
+
+		if (error) throw _filename + ": " + std::string(error);
+
+		return action;
+	}
 }
@@ -0,0 +1,152 @@
+#ifndef DAYTRENDER_BENCH_H
+#define DAYTRENDER_BENCH_H
+
+// local includes
+#include <data/candle.h>
+#include <data/pricehistory.h>
+
+// standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace daytrender
+{
+	/**
+	 * Small harness the benchmarks share. Every benchmark prints one json
+	 * object per line to stdout so results can be collected and compared
+	 * between releases, and everything else goes to stderr.
+	 */
+	namespace bench
+	{
+		struct Options
+		{
+			// candles of synthetic data
+			unsigned size = 10000;
+			// least amount of time a benchmark is measured for
+			double seconds = 0.25;
+			unsigned seed = 1;
+			// only benchmarks whose names contain this are run
+			const char *filter = nullptr;
+			// folder with the strategies folder in it
+			const char *dir = "..";
+		};
+
+		inline Options parse_options(int argc, const char *argv[])
+		{
+			Options options;
+
+			for (int i = 1; i < argc; ++i)
+			{
+				const char *arg = argv[i];
+				const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+				if (!value)
+				{
+					std::fprintf(stderr, "%s: %s needs a value\n", argv[0], arg);
+					std::exit(1);
+				}
+
+				if (!std::strcmp(arg, "--size")) options.size = std::strtoul(value, nullptr, 10);
+				else if (!std::strcmp(arg, "--seconds")) options.seconds = std::strtod(value, nullptr);
+				else if (!std::strcmp(arg, "--seed")) options.seed = std::strtoul(value, nullptr, 10);
+				else if (!std::strcmp(arg, "--filter")) options.filter = value;
+				else if (!std::strcmp(arg, "--dir")) options.dir = value;
+				else
+				{
+					std::fprintf(stderr, "usage: %s [--size candles] [--seconds time]"
+						" [--seed seed] [--filter name] [--dir folder]\n", argv[0]);
+					std::exit(1);
+				}
+
+				i++;
+			}
+
+			if (options.size < 2) options.size = 2;
+
+			return options;
+		}
+
+		// stops the compiler from optimizing away a result
+		template <typename T>
+		inline void keep(const T& value)
+		{
+			asm volatile("" : : "r,m"(value) : "memory");
+		}
+
+		/**
+		 * Random walk of candles that is the same for the same seed
+		 */
+		inline PriceHistory synthetic_history(unsigned size, unsigned interval,
+			unsigned seed)
+		{
+			PriceHistory hist(size, interval);
+			std::mt19937_64 rng(seed);
+			std::normal_distribution<double> step(0.0, 0.001);
+			std::uniform_real_distribution<double> wick(0.0, 0.0005);
+			double price = 100.0;
+
+			for (unsigned i = 0; i < size; ++i)
+			{
+				double open = price;
+				price *= std::exp(step(rng));
+				double high = std::max(open, price) * (1.0 + wick(rng));
+				double low = std::min(open, price) * (1.0 - wick(rng));
+
+				hist.set(i, Candle(open, high, low, price, 100.0 + 1000.0 * wick(rng)),
+					(long long)i * interval);
+			}
+
+			return hist;
+		}
+
+		/**
+		 * Runs an operation until it has taken at least the time in the
+		 * options, doubling the iterations every round, and prints the last
+		 * round as a json line.
+		 *
+		 * @param	name	name of the benchmark
+		 * @param	size	amount of data the operation works on
+		 * @param	op		operation to time
+		 */
+		template <typename Op>
+		void run(const Options& options, const char *name, unsigned size, Op&& op)
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			if (options.filter && !std::strstr(name, options.filter)) return;
+
+			// warming up caches and anything that is allocated on first use
+			op();
+
+			double limit = options.seconds * 1e9;
+			unsigned long long iterations = 1;
+
+			while (true)
+			{
+				Clock::time_point start = Clock::now();
+
+				for (unsigned long long i = 0; i < iterations; ++i) op();
+
+				double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+				if (elapsed >= limit || iterations >= (1ULL << 40))
+				{
+					std::printf("{\"bench\":\"%s\",\"size\":%u,\"iterations\":%llu,"
+						"\"total_ns\":%.0f,\"ns_per_op\":%.3f}\n",
+						name, size, iterations, elapsed, elapsed / iterations);
+					std::fflush(stdout);
+					return;
+				}
+
+				iterations *= 2;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,40 @@
+// local includes
+#include <bench.h>
+#include <data/chart.h>
+#include <util/arena.h>
+#include <util/indicators.h>
+
+using namespace daytrender;
+
+int main(int argc, const char *argv[])
+{
+	bench::Options options = bench::parse_options(argc, argv);
+	PriceHistory hist = bench::synthetic_history(options.size, 60, options.seed);
+	std::vector<unsigned> ranges = { 20, 50 };
+	unsigned window = 5;
+
+	bench::run(options, "chart_construct", options.size, [&]()
+	{
+		Chart chart(ranges, hist, window);
+		bench::keep(chart.size());
+	});
+
+	Arena arena;
+
+	bench::run(options, "chart_construct_arena", options.size, [&]()
+	{
+		arena.reset();
+		Chart chart(ranges, hist, window, arena);
+		bench::keep(chart.size());
+	});
+
+	Chart chart(arena);
+
+	bench::run(options, "chart_reset", options.size, [&]()
+	{
+		chart.reset(ranges, hist, window);
+		bench::keep(chart.size());
+	});
+
+	return 0;
+}
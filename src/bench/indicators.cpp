@@ -0,0 +1,72 @@
+// local includes
+#include <bench.h>
+#include <data/indicator.h>
+#include <util/indicators.h>
+
+// standard library
+#include <string>
+
+using namespace daytrender;
+
+struct Kernel
+{
+	const char *name;
+	void (*batch)(Indicator&, const PriceHistory&, unsigned);
+	indicators::stream::Step step;
+};
+
+const Kernel kernels[] =
+{
+	{ "sma", indicators::sma, indicators::stream::sma },
+	{ "ema", indicators::ema, indicators::stream::ema },
+	{ "wma", indicators::wma, indicators::stream::wma },
+	{ "rsi", indicators::rsi, indicators::stream::rsi },
+	{ "macd", indicators::macd, indicators::stream::macd },
+	{ "bollinger_upper", indicators::bollinger_upper, indicators::stream::bollinger_upper },
+	{ "bollinger_lower", indicators::bollinger_lower, indicators::stream::bollinger_lower },
+	{ "atr", indicators::atr, indicators::stream::atr },
+	{ "stochastic", indicators::stochastic, indicators::stream::stochastic },
+	{ "rolling_min", indicators::rolling_min, indicators::stream::rolling_min },
+	{ "rolling_max", indicators::rolling_max, indicators::stream::rolling_max }
+};
+
+int main(int argc, const char *argv[])
+{
+	bench::Options options = bench::parse_options(argc, argv);
+	PriceHistory hist = bench::synthetic_history(options.size, 60, options.seed);
+	unsigned range = 20;
+
+	// every value after the first range candles, like a backtest needs
+	unsigned length = (options.size > range) ? options.size - range : options.size;
+	Indicator data(length);
+
+	for (const Kernel& kernel : kernels)
+	{
+		std::string name = std::string("indicator_") + kernel.name;
+
+		bench::run(options, name.c_str(), options.size, [&]()
+		{
+			kernel.batch(data, hist, range);
+			bench::keep(data[length - 1]);
+		});
+
+		// one candle at a time, as a live asset gets them
+		name = std::string("indicator_stream_") + kernel.name;
+		indicators::Stream stream;
+
+		bench::run(options, name.c_str(), options.size, [&]()
+		{
+			indicators::stream::reset(stream, range);
+			double value = 0.0;
+
+			for (unsigned i = 0; i < hist.size(); ++i)
+			{
+				value = kernel.step(stream, hist[i], true);
+			}
+
+			bench::keep(value);
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+// local includes
+#include <bench.h>
+#include <data/paperaccount.h>
+#include <data/simaccount.h>
+
+using namespace daytrender;
+
+int main(int argc, const char *argv[])
+{
+	bench::Options options = bench::parse_options(argc, argv);
+	PriceHistory hist = bench::synthetic_history(options.size, 60, options.seed);
+	const double *close = hist.closes();
+
+	// a price update every candle and an order every fourth
+	bench::run(options, "paperaccount_orders", options.size, [&]()
+	{
+		PaperAccount acc(10000.0, 1, 0.0001, 1.0, close[0], true, 60, { 20, 50 });
+
+		for (unsigned i = 0; i < hist.size(); ++i)
+		{
+			acc.update_price(close[i]);
+
+			switch (i % 16)
+			{
+			case 0: acc.enter_long(); break;
+			case 4: acc.exit_long(); break;
+			case 8: acc.enter_short(); break;
+			case 12: acc.exit_short(); break;
+			}
+		}
+
+		acc.close_position();
+		bench::keep(acc.equity());
+	});
+
+	SimConfig config;
+	config.principal = 10000.0;
+	config.fee = 0.0001;
+	config.shorting_enabled = true;
+
+	// the same orders with the account sweeps use
+	bench::run(options, "simaccount_orders", options.size, [&]()
+	{
+		SimAccount acc(config, close[0]);
+
+		for (unsigned i = 0; i < hist.size(); ++i)
+		{
+			acc.update_price(close[i]);
+
+			switch (i % 16)
+			{
+			case 0: acc.enter_long(); break;
+			case 4: acc.exit_long(); break;
+			case 8: acc.enter_short(); break;
+			case 12: acc.exit_short(); break;
+			}
+		}
+
+		acc.close_position();
+		bench::keep(acc.equity());
+	});
+
+	return 0;
+}
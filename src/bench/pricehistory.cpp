@@ -0,0 +1,44 @@
+// local includes
+#include <bench.h>
+#include <data/pricehistory.h>
+#include <util/arena.h>
+
+using namespace daytrender;
+
+int main(int argc, const char *argv[])
+{
+	bench::Options options = bench::parse_options(argc, argv);
+	PriceHistory hist = bench::synthetic_history(options.size, 60, options.seed);
+	unsigned half = options.size / 2;
+
+	bench::run(options, "pricehistory_slice", half, [&]()
+	{
+		PriceHistory slice = hist.slice(half / 2, half);
+		bench::keep(slice.closes());
+	});
+
+	PriceHistory copy(half, 60);
+
+	bench::run(options, "pricehistory_set", half, [&]()
+	{
+		copy.set(0, hist, half / 2, half);
+		bench::keep(copy.closes()[half - 1]);
+	});
+
+	bench::run(options, "pricehistory_copy", options.size, [&]()
+	{
+		PriceHistory other(hist);
+		bench::keep(other.closes()[0]);
+	});
+
+	Arena arena;
+
+	bench::run(options, "pricehistory_arena", options.size, [&]()
+	{
+		Arena::Scope scope(arena);
+		PriceHistory other(options.size, 60, arena);
+		bench::keep(other.closes());
+	});
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+// local includes
+#include <bench.h>
+#include <api/strategy.h>
+#include <data/chart.h>
+#include <data/paperaccount.h>
+#include <interface/backtest.h>
+#include <util/arena.h>
+
+// standard library
+#include <string>
+
+using namespace daytrender;
+
+/**
+ * Benchmarks that go through the plugin boundary with simplema, which has
+ * to be built into the strategies folder of --dir
+ */
+int main(int argc, const char *argv[])
+{
+	bench::Options options = bench::parse_options(argc, argv);
+	PriceHistory hist = bench::synthetic_history(options.size, 60, options.seed);
+	std::vector<unsigned> ranges = { 50, 20 };
+
+	Strategy strategy;
+
+	try
+	{
+		strategy = Strategy("simplema", options.dir);
+	}
+	catch (const std::string& error)
+	{
+		std::fprintf(stderr, "failed to load strategy: %s\n", error.c_str());
+		return 1;
+	}
+
+	if (!strategy.is_bound())
+	{
+		std::fprintf(stderr, "failed to load strategy\n");
+		return 1;
+	}
+
+	unsigned window = strategy.data_length();
+	unsigned history = window + ranges[0];
+	PriceHistory recent = hist.slice(hist.size() - history, history);
+	Chart chart(Arena::local());
+
+	// one update of a live asset without incremental state
+	bench::run(options, "strategy_execute", history, [&]()
+	{
+		strategy.execute(chart, recent, ranges);
+		bench::keep(chart.action());
+	});
+
+	std::vector<short> actions;
+
+	bench::run(options, "strategy_execute_series", options.size, [&]()
+	{
+		strategy.execute_series(chart, actions, hist, ranges, window);
+		bench::keep(actions.back());
+	});
+
+	if (strategy.is_incremental())
+	{
+		std::shared_ptr<void> state = strategy.create_state(ranges);
+		strategy.init(state.get(), recent);
+		long long time = recent.timestamp(history - 1);
+
+		bench::run(options, "strategy_on_candle", options.size, [&]()
+		{
+			short action = NOTHING;
+
+			// every candle is newer than the last, so every one is committed
+			for (unsigned i = 0; i < hist.size(); ++i)
+			{
+				time += 60;
+				action = strategy.on_candle(state.get(), hist[i], time);
+			}
+
+			bench::keep(action);
+		});
+	}
+
+	bench::run(options, "backtest_permutation", options.size, [&]()
+	{
+		PaperAccount acc(10000.0, 1, 0.0001, 1.0, hist.closes()[0], true, 60,
+			{ (int)ranges[0], (int)ranges[1] });
+		backtest_permutation(acc, hist, &strategy, ranges, window, chart, actions);
+		bench::keep(acc.equity());
+	});
+
+	SimConfig config;
+	config.principal = 10000.0;
+	config.fee = 0.0001;
+	config.shorting_enabled = true;
+
+	bench::run(options, "backtest_permutation_sim", options.size, [&]()
+	{
+		SimAccount acc(config, hist.closes()[0]);
+		backtest_permutation(acc, hist, &strategy, ranges, window, chart, actions);
+		bench::keep(acc.equity());
+	});
+
+	// a sweep of eight permutations one at a time and then in lockstep
+	std::vector<std::vector<unsigned>> sweep;
+	for (unsigned i = 0; i < 8; ++i) sweep.push_back({ 30 + i * 5, 10 + i * 2 });
+
+	bench::run(options, "backtest_sweep8_sequential", options.size, [&]()
+	{
+		for (const std::vector<unsigned>& set : sweep)
+		{
+			SimAccount acc(config, hist.closes()[0]);
+			backtest_permutation(acc, hist, &strategy, set, window, chart, actions);
+			bench::keep(acc.equity());
+		}
+	});
+
+	std::vector<Chart> charts;
+	std::vector<std::vector<short>> batch_actions;
+
+	bench::run(options, "backtest_sweep8_batch", options.size, [&]()
+	{
+		std::vector<SimAccount> accounts(sweep.size(), SimAccount(config, hist.closes()[0]));
+		backtest_batch(accounts, hist, &strategy, sweep, window, charts, batch_actions);
+		bench::keep(accounts[0].equity());
+	});
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <data/paperaccount.h>
 #include <data/mathutil.h>
 #include <interface/backtest.h>
+#include <util/latency.h>
 
 // external libararies
 #include <hirzel/logger.h>
@@ -18,7 +19,8 @@ namespace daytrender
 		_candle_count(get_candle_count()),
 		_ticker(get_ticker(config)),
 		_strategy(get_strategy(config, dir)),
-		_risk(get_risk()) { }
+		_candles(_candle_count, _interval),
+		_state(_strategy.create_state(_ranges)) { }
 	
 	unsigned Asset::get_interval(const Data& config) const
 	{
@@ -27,7 +29,7 @@ namespace daytrender
 
 		const Data& interval = config["interval"];
 
-		if (!interval.is_uint())
+		if (!interval.is_uint() || interval.to_uint() == 0)
 			throw std::invalid_argument("Asset: interval ("
 				+ interval.to_string()
 				+ ") must be a natural number");
@@ -107,23 +109,63 @@ namespace daytrender
 		return max;
 	}
 
-	double Asset::get_risk() const
+	unsigned Asset::update(const PriceHistory& hist)
 	{
-		// PaperAccount acc = interface::backtest(this);
-		// double kelly = acc.kelly_criterion();
-		// _risk = (kelly >= 0.0 ? kelly : 0.0);
-		WARNING("get_risk() is not yet implemented: setting risk to 0.0");
-		return 0.0;
+		DEBUG("updating $%s", _ticker);
+		latency::Timer timer(latency::EXECUTE);
+		
+		try
+		{
+			// the chart is reused between updates
+			_strategy.execute(_chart, hist, _ranges);
+			return _chart.action();
+		}
+		catch (std::string err)
+		{
+			ERROR("(%s) %s: %s", _ticker, _strategy.filename(), err);
+			return ERROR;
+		}
 	}
 
-	unsigned Asset::update(const PriceHistory& hist)
+	/**
+	 * Updates the asset with the candles in its window. Incremental
+	 * strategies are only fed the candles they have not seen, along with
+	 * the last one they were fed in case it changed. If that candle is no
+	 * longer in the window, the state is started over from it.
+	 */
+	unsigned Asset::update()
 	{
+		if (!_state) return update(_candles.view());
+
 		DEBUG("updating $%s", _ticker);
-		
+		latency::Timer timer(latency::EXECUTE);
+
 		try
 		{
-			Chart data = _strategy.execute(hist, _ranges);
-			return data.action();
+			PriceHistory hist = _candles.view();
+			if (hist.empty()) throw std::string("there are no candles to update with");
+
+			const long long *time = hist.timestamps();
+			unsigned i = hist.size();
+			short action = NOTHING;
+
+			while (i > 0 && time[i - 1] > _state_time) i--;
+
+			if (i == 0 || time[i - 1] != _state_time)
+			{
+				action = _strategy.init(_state.get(), hist);
+			}
+			else
+			{
+				for (i = i - 1; i < hist.size(); ++i)
+				{
+					action = _strategy.on_candle(_state.get(), hist[i], time[i]);
+				}
+			}
+
+			_state_time = time[hist.size() - 1];
+
+			return action;
 		}
 		catch (std::string err)
 		{
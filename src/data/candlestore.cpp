@@ -0,0 +1,229 @@
+#include <data/candlestore.h>
+
+// standard library
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+// system
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace daytrender
+{
+	// every column file is an array of these
+	static_assert(sizeof(double) == 8 && sizeof(long long) == 8,
+		"candle store columns must be 8 bytes wide");
+
+	static const char *COLUMNS[] = { "time", "open", "high", "low", "close", "volume" };
+	static const unsigned COLUMN_COUNT = 6;
+	static const size_t VALUE_SIZE = 8;
+
+	/**
+	 * Maps every column of a stored history. A write that was cut short
+	 * can leave the columns with different lengths, so only the candles
+	 * that every column has are mapped.
+	 */
+	CandleMap::CandleMap(const std::string& path, unsigned interval)
+	{
+		size_t count = SIZE_MAX;
+
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			std::error_code err;
+			uintmax_t bytes = fs::file_size(path + "/" + COLUMNS[i], err);
+			if (err) bytes = 0;
+			if (bytes / VALUE_SIZE < count) count = bytes / VALUE_SIZE;
+		}
+
+		_bytes = count * VALUE_SIZE;
+
+		if (count == 0)
+		{
+			_history = PriceHistory(nullptr, nullptr, nullptr, nullptr, nullptr,
+				nullptr, 0, interval);
+			return;
+		}
+
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			std::string filepath = path + "/" + COLUMNS[i];
+			int fd = open(filepath.c_str(), O_RDONLY);
+
+			if (fd < 0)
+			{
+				unmap();
+				throw std::runtime_error("CandleMap: failed to open " + filepath);
+			}
+
+			void* data = mmap(nullptr, _bytes, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+
+			if (data == MAP_FAILED)
+			{
+				unmap();
+				throw std::runtime_error("CandleMap: failed to map " + filepath);
+			}
+
+			_columns[i] = data;
+		}
+
+		_history = PriceHistory((double*)_columns[1], (double*)_columns[2],
+			(double*)_columns[3], (double*)_columns[4], (double*)_columns[5],
+			(long long*)_columns[0], count, interval);
+	}
+
+	CandleMap::~CandleMap()
+	{
+		unmap();
+	}
+
+	void CandleMap::unmap()
+	{
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			if (_columns[i]) munmap(_columns[i], _bytes);
+			_columns[i] = nullptr;
+		}
+	}
+
+	CandleStore::CandleStore(const std::string& dir) :
+	_dir(dir)
+	{}
+
+	std::string CandleStore::get_path(const std::string& ticker,
+		unsigned interval) const
+	{
+		return _dir + "/" + ticker + "/" + std::to_string(interval);
+	}
+
+	std::shared_ptr<const CandleMap> CandleStore::get_map(const std::string& path,
+		unsigned interval)
+	{
+		std::shared_ptr<const CandleMap>& map = _maps[path];
+		if (!map) map = std::make_shared<const CandleMap>(path, interval);
+		return map;
+	}
+
+	/**
+	 * Writes the candles of hist from offset onward to every column. When
+	 * not appending, the columns are written to temporary files and then
+	 * renamed over the old ones so that existing maps stay intact.
+	 */
+	void CandleStore::write(const std::string& path, const PriceHistory& hist,
+		unsigned offset, bool append) const
+	{
+		const void* columns[] =
+		{
+			hist.timestamps(),
+			hist.opens(),
+			hist.highs(),
+			hist.lows(),
+			hist.closes(),
+			hist.volumes()
+		};
+
+		size_t bytes = (size_t)(hist.size() - offset) * VALUE_SIZE;
+
+		fs::create_directories(path);
+
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			std::string filepath = path + "/" + COLUMNS[i];
+			if (!append) filepath += ".tmp";
+
+			std::ofstream file(filepath, std::ios::binary
+				| (append ? std::ios::app : std::ios::trunc));
+
+			if (bytes > 0)
+				file.write((const char*)columns[i] + offset * VALUE_SIZE, bytes);
+
+			if (!file)
+				throw std::runtime_error("CandleStore: failed to write " + filepath);
+		}
+
+		if (append) return;
+
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			std::string filepath = path + "/" + COLUMNS[i];
+			fs::rename(filepath + ".tmp", filepath);
+		}
+	}
+
+	std::shared_ptr<const CandleMap> CandleStore::load(const std::string& ticker,
+		unsigned interval)
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		return get_map(get_path(ticker, interval), interval);
+	}
+
+	/**
+	 * Adds the candles of hist that are newer than the last stored one to
+	 * the end of the store.
+	 *
+	 * @param	ticker	ticker the candles are for
+	 * @param	hist	candles in order with timestamps set
+	 * @return			map of the store after appending
+	 */
+	std::shared_ptr<const CandleMap> CandleStore::append(const std::string& ticker,
+		const PriceHistory& hist)
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+
+		std::string path = get_path(ticker, hist.interval());
+		std::shared_ptr<const CandleMap> map = get_map(path, hist.interval());
+
+		unsigned offset = 0;
+		if (!map->empty())
+		{
+			while (offset < hist.size() && hist.timestamps()[offset] <= map->last_timestamp())
+				offset++;
+		}
+
+		if (offset == hist.size()) return map;
+
+		// dropping the end of any column that was written past the others
+		for (unsigned i = 0; i < COLUMN_COUNT; ++i)
+		{
+			std::error_code err;
+			std::string filepath = path + "/" + COLUMNS[i];
+			uintmax_t bytes = (uintmax_t)map->size() * VALUE_SIZE;
+
+			if (fs::exists(filepath, err) && fs::file_size(filepath, err) > bytes)
+				fs::resize_file(filepath, bytes);
+		}
+
+		write(path, hist, offset, true);
+
+		map = std::make_shared<const CandleMap>(path, hist.interval());
+		_maps[path] = map;
+
+		return map;
+	}
+
+	/**
+	 * Replaces everything stored for the ticker with hist. This is for when
+	 * the store cannot be continued, like when candles are missing between
+	 * its end and the start of the new ones.
+	 */
+	std::shared_ptr<const CandleMap> CandleStore::replace(const std::string& ticker,
+		const PriceHistory& hist)
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+
+		std::string path = get_path(ticker, hist.interval());
+
+		write(path, hist, 0, false);
+
+		std::shared_ptr<const CandleMap> map = std::make_shared<const CandleMap>(path,
+			hist.interval());
+		_maps[path] = map;
+
+		return map;
+	}
+}
@@ -0,0 +1,193 @@
+#include <data/candlewindow.h>
+
+// standard library
+#include <cstring>
+#include <utility>
+
+namespace daytrender
+{
+	CandleWindow::CandleWindow(unsigned capacity, unsigned interval) :
+	_buffer(capacity, interval)
+	{
+		_capacity = capacity;
+		_interval = interval;
+
+		if (_capacity == 0) return;
+
+		// every column is twice the capacity
+		unsigned length = _capacity * 2;
+		_open = new double[length * 5];
+		_high = _open + length;
+		_low = _high + length;
+		_close = _low + length;
+		_volume = _close + length;
+		_time = new long long[length];
+	}
+
+	CandleWindow::CandleWindow(const CandleWindow& other)
+	{
+		*this = other;
+	}
+
+	CandleWindow::CandleWindow(CandleWindow&& other)
+	{
+		*this = std::move(other);
+	}
+
+	CandleWindow::~CandleWindow()
+	{
+		delete[] _open;
+		delete[] _time;
+	}
+
+	CandleWindow& CandleWindow::operator=(const CandleWindow& other)
+	{
+		if (this == &other) return *this;
+
+		*this = CandleWindow(other._capacity, other._interval);
+
+		if (_capacity == 0) return *this;
+
+		std::memcpy(_open, other._open, _capacity * 2 * 5 * sizeof(double));
+		std::memcpy(_time, other._time, _capacity * 2 * sizeof(long long));
+		_next = other._next;
+		_size = other._size;
+
+		return *this;
+	}
+
+	CandleWindow& CandleWindow::operator=(CandleWindow&& other)
+	{
+		if (this == &other) return *this;
+
+		delete[] _open;
+		delete[] _time;
+
+		_open = other._open;
+		_high = other._high;
+		_low = other._low;
+		_close = other._close;
+		_volume = other._volume;
+		_time = other._time;
+		_capacity = other._capacity;
+		_interval = other._interval;
+		_next = other._next;
+		_size = other._size;
+		_buffer = std::move(other._buffer);
+
+		other._open = other._high = other._low = other._close = other._volume = nullptr;
+		other._time = nullptr;
+		other._capacity = 0;
+		other._next = 0;
+		other._size = 0;
+
+		return *this;
+	}
+
+	// writes a candle to both halves of the columns
+	void CandleWindow::write(unsigned index, const Candle& candle, long long time)
+	{
+		unsigned mirror = index + _capacity;
+
+		_open[index] = _open[mirror] = candle.open();
+		_high[index] = _high[mirror] = candle.high();
+		_low[index] = _low[mirror] = candle.low();
+		_close[index] = _close[mirror] = candle.close();
+		_volume[index] = _volume[mirror] = candle.volume();
+		_time[index] = _time[mirror] = time;
+	}
+
+	/**
+	 * Adds a candle to the end of the window. Once the window is full,
+	 * this drops the oldest candle.
+	 */
+	void CandleWindow::push(const Candle& candle, long long time)
+	{
+		if (_capacity == 0) return;
+
+		write(_next, candle, time);
+		_next = (_next + 1) % _capacity;
+
+		if (_size < _capacity) _size++;
+	}
+
+	/**
+	 * Replaces the newest candle, like when it was fetched before it closed
+	 */
+	void CandleWindow::set_back(const Candle& candle, long long time)
+	{
+		if (_size == 0)
+			throw std::out_of_range("CandleWindow::set_back(): window is empty");
+
+		write((_next + _capacity - 1) % _capacity, candle, time);
+	}
+
+	/**
+	 * Builds candles out of streamed prices. A price during the newest
+	 * candle is folded into it and one after it starts a new candle. New
+	 * candles start a whole number of intervals after the newest one so
+	 * they line up with the candles of the broker. Prices from before the
+	 * newest candle are ignored, as is every price until the window has a
+	 * candle to line up with.
+	 *
+	 * @param	price	price of the tick
+	 * @param	time	epoch seconds of the tick
+	 * @return			true if a new candle was started, which means the one
+	 * 					before it has closed
+	 */
+	bool CandleWindow::tick(double price, long long time)
+	{
+		if (_size == 0 || _interval == 0) return false;
+
+		unsigned index = (_next + _capacity - 1) % _capacity;
+		long long start = _time[index];
+
+		if (time < start) return false;
+
+		if (time < start + _interval)
+		{
+			double high = (price > _high[index]) ? price : _high[index];
+			double low = (price < _low[index]) ? price : _low[index];
+
+			write(index, Candle(_open[index], high, low, price, _volume[index] + 1.0), start);
+
+			return false;
+		}
+
+		start += (time - start) / _interval * _interval;
+		push(Candle(price, price, price, price, 1.0), start);
+
+		return true;
+	}
+
+	/**
+	 * Fills the window with the newest candles of a history
+	 */
+	void CandleWindow::assign(const PriceHistory& hist)
+	{
+		clear();
+
+		unsigned count = (hist.size() > _capacity) ? _capacity : hist.size();
+
+		for (unsigned i = hist.size() - count; i < hist.size(); ++i)
+		{
+			push(hist[i], hist.timestamp(i));
+		}
+	}
+
+	/**
+	 * Creates a non-owning history of the window from oldest to newest.
+	 * It is only valid until the window is next changed.
+	 */
+	PriceHistory CandleWindow::view() const
+	{
+		unsigned i = (_size > 0) ? first() : 0;
+
+		if (!_open)
+			return PriceHistory(nullptr, nullptr, nullptr, nullptr, nullptr,
+				nullptr, 0, _interval);
+
+		return PriceHistory(_open + i, _high + i, _low + i, _close + i,
+			_volume + i, _time + i, _size, _interval);
+	}
+}
@@ -1,5 +1,9 @@
 #include <data/chart.h>
 
+// standard library
+#include <new>
+#include <utility>
+
 
 namespace daytrender
 {
@@ -9,8 +13,7 @@ namespace daytrender
 		_ranges = ranges;
 
 		_candles = candles;
-		_size = ranges.size();
-		_dataset = new Indicator[_size];
+		allocate_dataset(ranges.size());
 
 		// initializing all the indicators to same size
 		for (int i = 0; i < _size; i++)
@@ -19,6 +22,26 @@ namespace daytrender
 		}
 	}
 
+	/**
+	 * Creates an empty chart whose indicators will be allocated from an
+	 * arena when it is reset. It must not outlive the arena's current scope.
+	 */
+	Chart::Chart(Arena& arena)
+	{
+		_arena = &arena;
+	}
+
+	/**
+	 * Same as the normal constructor but everything is allocated from an
+	 * arena. The candles are viewed instead of copied.
+	 */
+	Chart::Chart(const std::vector<unsigned>& ranges,
+		const PriceHistory& candles, unsigned data_length, Arena& arena)
+	{
+		_arena = &arena;
+		reset(ranges, candles, data_length);
+	}
+
 	Chart::Chart(const Chart& other)
 	{
 		*this = other;
@@ -30,24 +53,69 @@ namespace daytrender
 		_size = other._size;
 		_action = other._action;
 		_label = other._label;
-		_ranges = other._ranges;
-		_candles = other._candles;
+		_ranges = std::move(other._ranges);
+		_candles = std::move(other._candles);
+		_arena = other._arena;
 
 		other._dataset = nullptr;
+		other._size = 0;
 	}
 
 	Chart::~Chart()
 	{
-		delete[] _dataset;
+		free_dataset();
+	}
+
+	/**
+	 * Replaces the dataset with one of empty indicators. In an arena the
+	 * indicators are constructed in place so that they grow into it too.
+	 */
+	void Chart::allocate_dataset(short size)
+	{
+		free_dataset();
+		_size = size;
+
+		if (!_arena)
+		{
+			_dataset = new Indicator[_size];
+			return;
+		}
+
+		_dataset = _arena->allocate<Indicator>(_size);
+
+		for (int i = 0; i < _size; i++)
+		{
+			new (_dataset + i) Indicator(0, *_arena);
+		}
+	}
+
+	void Chart::free_dataset()
+	{
+		if (!_arena)
+		{
+			delete[] _dataset;
+		}
+		else if (_dataset)
+		{
+			for (int i = 0; i < _size; i++)
+			{
+				_dataset[i].~Indicator();
+			}
+		}
+
+		_dataset = nullptr;
 	}
 
 	Chart& Chart::operator=(const Chart& other)
 	{
+		if (this == &other) return *this;
+
 		_ranges = other.ranges();
 		_candles = other.candles();
 
-		_size = other.size();
-		_dataset = new Indicator[_size];
+		free_dataset();
+		_arena = nullptr;
+		allocate_dataset(other.size());
 
 		for (int i = 0; i < _size; i++)
 		{
@@ -56,4 +124,95 @@ namespace daytrender
 
 		return *this;
 	}
+
+	/**
+	 * Creates a view of the chart where the candles and every indicator
+	 * are sliced to the same window. The indicators must be aligned with
+	 * the candles (same size) for this to be meaningful. The view does
+	 * not own any data and is only valid for as long as this chart is.
+	 * 
+	 * @param	offset	index of the first candle in the window
+	 * @param	size	amount of candles in the window
+	 * @return			non-owning chart of the window
+	 */
+	Chart Chart::slice(unsigned offset, unsigned size) const
+	{
+		Chart out;
+
+		out._size = _size;
+		out._action = _action;
+		out._label = _label;
+		out._ranges = _ranges;
+		out._candles = _candles.slice(offset, size);
+		out._dataset = new Indicator[_size];
+
+		for (int i = 0; i < _size; i++)
+		{
+			out._dataset[i] = _dataset[i].slice(offset, size);
+		}
+
+		return out;
+	}
+
+	/**
+	 * Same as slice(offset, size) but the view is written into an existing
+	 * chart, so viewing every window of a chart in turn only allocates for
+	 * the first one.
+	 */
+	void Chart::slice(unsigned offset, unsigned size, Chart& out) const
+	{
+		if (out._size != _size || !out._dataset)
+		{
+			out.allocate_dataset(_size);
+		}
+
+		out._action = _action;
+		out._label = _label;
+		out._ranges = _ranges;
+		out._candles = _candles.slice(offset, size);
+
+		for (int i = 0; i < _size; i++)
+		{
+			out._dataset[i] = _dataset[i].slice(offset, size);
+		}
+	}
+
+	/**
+	 * Prepares the chart for another execution without reallocating it.
+	 * The candles are viewed instead of copied, so they must outlive the
+	 * execution, and the indicator buffers are reused unless they have to
+	 * grow.
+	 * 
+	 * @param	ranges		ranges of the indicators
+	 * @param	candles		candles to execute over
+	 * @param	data_length	size of every indicator
+	 */
+	void Chart::reset(const std::vector<unsigned>& ranges,
+		const PriceHistory& candles, unsigned data_length)
+	{
+		_action = 0;
+		_ranges = ranges;
+		set_candles(candles);
+
+		if (_size != (short)ranges.size() || !_dataset)
+		{
+			allocate_dataset(ranges.size());
+		}
+
+		for (int i = 0; i < _size; i++)
+		{
+			_dataset[i].resize(data_length);
+		}
+	}
+
+	/**
+	 * Points the chart at other candles without copying them or touching
+	 * the indicators
+	 */
+	void Chart::set_candles(const PriceHistory& candles)
+	{
+		_candles = candles.empty()
+			? PriceHistory()
+			: candles.slice(0, candles.size());
+	}
 }
\ No newline at end of file
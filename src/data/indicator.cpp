@@ -9,9 +9,23 @@ namespace daytrender
 	Indicator::Indicator(unsigned size)
 	{
 		_size = size;
+		_capacity = size;
 		_data = new double[_size];
 	}
 
+	/**
+	 * Creates an indicator whose buffer is allocated from an arena. It does
+	 * not own the buffer, so it must not outlive the arena's current scope.
+	 */
+	Indicator::Indicator(unsigned size, Arena& arena)
+	{
+		_slice = true;
+		_arena = &arena;
+		_size = size;
+		_capacity = size;
+		_data = arena.allocate<double>(_size);
+	}
+
 	Indicator::Indicator(const Indicator& other)
 	{
 		*this = other;
@@ -21,28 +35,119 @@ namespace daytrender
 	{
 		_data = other._data;
 		_size = other._size;
+		_capacity = other._capacity;
 		_type = other._type;
 		_label = other._label;
+		_slice = other._slice;
+		_arena = other._arena;
 		
 		other._data = nullptr;
 	}
 
+	Indicator::Indicator(double* parent_data, const char* type, const char* label,
+		unsigned offset, unsigned size)
+	{
+		_slice = true;
+		_type = type;
+		_label = label;
+		_data = parent_data + offset;
+		_size = size;
+		_capacity = size;
+	}
+
 	Indicator::~Indicator()
 	{
-		delete[] _data;
+		if (!_slice)
+		{
+			delete[] _data;
+		}
 	}
 
 	Indicator& Indicator::operator=(const Indicator& other)
 	{
+		if (this == &other) return *this;
+
+		if (!_slice)
+		{
+			delete[] _data;
+		}
+
 		_size = other.size();
+		_capacity = _size;
 		_type = other.type();
 		_label = other.label();
 		_data = new double[_size];
-		for (int i = 0; i < _size; i++)
+		_slice = false;
+		_arena = nullptr;
+		for (unsigned i = 0; i < _size; i++)
 		{
 			_data[i] = other[i];
 		}
 
 		return *this;
 	}
-}
\ No newline at end of file
+
+	Indicator& Indicator::operator=(Indicator&& other)
+	{
+		if (!_slice)
+		{
+			delete[] _data;
+		}
+
+		_data = other._data;
+		_size = other._size;
+		_capacity = other._capacity;
+		_type = other._type;
+		_label = other._label;
+		_slice = other._slice;
+		_arena = other._arena;
+
+		other._data = nullptr;
+
+		return *this;
+	}
+
+	Indicator Indicator::slice(unsigned offset, unsigned size) const
+	{
+		if (offset + size > _size)
+			throw std::out_of_range("Indicator: upper bound of slice ("
+				+ std::to_string(offset + size)
+				+ ") is greater than size of parent ("
+				+ std::to_string(_size)
+				+ ")");
+
+		return Indicator(_data, _type, _label, offset, size);
+	}
+
+	/**
+	 * Changes the size of the indicator. Its buffer is only reallocated if
+	 * it has to grow, so it can be reused between executions. The values
+	 * are not kept. Indicators made in an arena grow into it.
+	 */
+	void Indicator::resize(unsigned size)
+	{
+		if ((!_slice || _arena) && size <= _capacity)
+		{
+			_size = size;
+			return;
+		}
+
+		if (_arena)
+		{
+			_data = _arena->allocate<double>(size);
+			_size = size;
+			_capacity = size;
+			return;
+		}
+
+		if (!_slice)
+		{
+			delete[] _data;
+		}
+
+		_data = new double[size];
+		_size = size;
+		_capacity = size;
+		_slice = false;
+	}
+}
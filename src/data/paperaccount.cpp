@@ -14,6 +14,7 @@ namespace daytrender
 	{
 		_principal = principal;
 		_balance = principal;
+		_peak_balance = principal;
 		_leverage = (double)leverage;
 		_fee = fee;
 		_order_minimum = order_minimum;
@@ -62,7 +63,7 @@ namespace daytrender
 			_long_losses -= returns;
 		}
 
-		_return_history.push_back(returns / _balance);
+		record_return(returns);
 
 		_balance += returns;
 		_margin_used = 0;
@@ -116,7 +117,7 @@ namespace daytrender
 			_short_losses -= returns;
 		}
 
-		_return_history.push_back(returns / _balance);
+		record_return(returns);
 
 		_balance += returns;
 		_margin_used = 0.0;
@@ -131,6 +132,52 @@ namespace daytrender
 		return true;
 	}
 
+	/**
+	 * Updates the statistics of the trades with the returns of one that
+	 * was just closed, before they are added to the balance. Everything is
+	 * kept as running sums so reading the statistics takes constant time
+	 * and nothing grows with the amount of trades.
+	 */
+	void PaperAccount::record_return(double returns)
+	{
+		double ret = returns / _balance;
+
+		// welford's algorithm
+		_return_count++;
+		double delta = ret - _return_mean;
+		_return_mean += delta / _return_count;
+		_return_m2 += delta * (ret - _return_mean);
+
+		if (ret < 0.0) _downside_sum += ret * ret;
+
+		double balance = _balance + returns;
+
+		if (balance > _peak_balance)
+		{
+			_peak_balance = balance;
+		}
+		else if (_peak_balance > 0.0)
+		{
+			double drawdown = (_peak_balance - balance) / _peak_balance;
+			if (drawdown > _max_drawdown) _max_drawdown = drawdown;
+		}
+
+		if (returns > 0.0)
+		{
+			_streak = (_streak > 0) ? _streak + 1 : 1;
+			if (_streak > _max_win_streak) _max_win_streak = _streak;
+		}
+		else if (returns < 0.0)
+		{
+			_streak = (_streak < 0) ? _streak - 1 : -1;
+			if (-_streak > _max_loss_streak) _max_loss_streak = -_streak;
+		}
+		else
+		{
+			_streak = 0;
+		}
+	}
+
 	double PaperAccount::net_return() const
 	{
 		return equity() - _principal;
@@ -230,30 +277,41 @@ namespace daytrender
 		return 0.0;
 	}
 
+	// sample standard deviation of the returns of trades
 	double PaperAccount::return_volatility() const
 	{
-		if (_return_history.empty()) return 0.0;
-		// getting mean return
-		double return_mean = 0.0;
-		for (double ret : _return_history) return_mean += ret;
-		return_mean /= _return_history.size();
-
-		// getting squared deviation sum
-		double sq_sum = 0.0;
-		for (double ret : _return_history)
-		{
-			double deviation = ret - return_mean;
-			sq_sum += (deviation * deviation);
-		}
-		// standard deviation calc
-		return std::sqrt(sq_sum / (_return_history.size() - 1));
+		if (_return_count < 2) return 0.0;
+		return std::sqrt(_return_m2 / (_return_count - 1));
 	}
 
-	double PaperAccount::sharpe_ratio() const 
+	// deviation of the returns of trades below zero
+	double PaperAccount::downside_deviation() const
+	{
+		if (_return_count == 0) return 0.0;
+		return std::sqrt(_downside_sum / _return_count);
+	}
+
+	// return of holding the asset instead
+	double PaperAccount::risk_free_rate() const
 	{
 		double avg_price = _price_sum / (double)_updates;
-		double risk_free_rate = ((_price / _initial_price - 1.0) + ((avg_price / _initial_price - 1.0) * 2.0) + ((_price / avg_price - 1.0) * 2.0)) / 3.0;
-		return (pct_return() - risk_free_rate) / return_volatility();
+		return ((_price / _initial_price - 1.0) + ((avg_price / _initial_price - 1.0) * 2.0) + ((_price / avg_price - 1.0) * 2.0)) / 3.0;
+	}
+
+	// 0 until there are enough trades to measure volatility
+	double PaperAccount::sharpe_ratio() const 
+	{
+		double volatility = return_volatility();
+		if (volatility == 0.0) return 0.0;
+		return (pct_return() - risk_free_rate()) / volatility;
+	}
+
+	// 0 until a trade has lost
+	double PaperAccount::sortino_ratio() const
+	{
+		double deviation = downside_deviation();
+		if (deviation == 0.0) return 0.0;
+		return (pct_return() - risk_free_rate()) / deviation;
 	}
 
 	double PaperAccount::kelly_criterion() const
@@ -302,7 +360,11 @@ namespace daytrender
 		out += "\n    L Prft Rate :  % " + std::to_string(long_profit_rate() * 100.0);
 		out += "\n    S Win Rate  :  % " + std::to_string(short_win_rate() * 100.0);
 		out += "\n    S Prft Rate :  % " + std::to_string(short_profit_rate() * 100.0);
+		out += "\n    Max Drawdn  :  % " + std::to_string(_max_drawdown * 100.0);
+		out += "\n    Win Streak  :    " + std::to_string(_max_win_streak);
+		out += "\n    Loss Streak :    " + std::to_string(_max_loss_streak);
 		out += "\n    Sharpe R    :    " + std::to_string(sharpe_ratio());
+		out += "\n    Sortino R   :    " + std::to_string(sortino_ratio());
 		out += "\n    Kelly R     :    " + std::to_string(kelly_criterion());
 		out += "\n}";
 		return out;
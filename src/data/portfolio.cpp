@@ -1,5 +1,9 @@
 #include <data/portfolio.h>
 
+// local includes
+#include <interface/backtest.h>
+#include <util/latency.h>
+
 // standard library
 #include <cmath>
 
@@ -22,6 +26,7 @@ namespace daytrender
 		_max_loss(get_max_loss(config)),
 		_history_length(get_history_length(config)),
 		_closeout_buffer(get_closeout_buffer(config)),
+		_walk_forward(get_walk_forward(config)),
 		_assets(get_assets(config, dir)),
 		_label(label)
 	{
@@ -74,10 +79,11 @@ namespace daytrender
 
 		_client.api_version();
 
-		// verifying api version of client matches current one
-		if (_client.api_version() != CLIENT_API_VERSION)
+		// verifying api version of client is supported
+		if (_client.api_version() < MIN_CLIENT_API_VERSION
+			|| _client.api_version() > CLIENT_API_VERSION)
 		{
-			ERROR("%s: api version for (%u) did not match current api version: %u)",
+			ERROR("%s: api version (%u) is not supported by current api version: %u)",
 				_label, _client.api_version(), CLIENT_API_VERSION);
 			return;
 		}
@@ -219,6 +225,43 @@ namespace daytrender
 		return closeout_buffer.to_uint();
 	}
 
+	// walking forward is optional, and without it every asset risks nothing
+	WalkForwardConfig Portfolio::get_walk_forward(const Data& config) const
+	{
+		WalkForwardConfig out;
+
+		if (!config.contains("walk_forward")) return out;
+
+		const Data& walk_forward = config["walk_forward"];
+
+		if (!walk_forward.is_table())
+			throw std::invalid_argument("'walk_forward' must be a table");
+
+		const char *keys[] = { "min_range", "max_range", "granularity", "in_sample", "out_of_sample" };
+		unsigned *values[] = { &out.min_range, &out.max_range, &out.granularity,
+			&out.in_sample, &out.out_of_sample };
+
+		for (unsigned i = 0; i < 5; ++i)
+		{
+			if (!walk_forward.contains(keys[i]))
+				throw std::invalid_argument(std::string("'walk_forward.") + keys[i]
+					+ "' must be defined in config");
+
+			const Data& value = walk_forward[keys[i]];
+
+			if (!value.is_uint() || value.to_uint() == 0)
+				throw std::invalid_argument(std::string("'walk_forward.") + keys[i]
+					+ "' must be a natural number");
+
+			*values[i] = value.to_uint();
+		}
+
+		if (out.min_range > out.max_range)
+			throw std::out_of_range("'walk_forward.min_range' must not be above 'walk_forward.max_range'");
+
+		return out;
+	}
+
 	Client Portfolio::get_client(const Data& config, const std::string& dir) const
 	{
 		if (!config.contains("client"))
@@ -259,6 +302,9 @@ namespace daytrender
 
 	void Portfolio::update()
 	{
+		latency::Timer timer(latency::PORTFOLIO_UPDATE);
+		std::lock_guard<std::recursive_mutex> lock(*_mtx);
+
 		if (!_ok)
 		{
 			WARNING("%s portfolio is not okay and cannot be updated", _label);
@@ -329,58 +375,199 @@ namespace daytrender
 			// skip if it shouldn't update yet
 			if (!asset.should_update()) continue;
 
-			Result<PriceHistory> res = _client.get_price_history(asset);
-			if (!res)
+			update_asset(asset);
+		}
+	}
+
+	/**
+	 * Fetches the new candles of an asset, runs its strategy and places any
+	 * order it asks for. The asset's next update is the end of the candle
+	 * it was updated during, even if this fails, so that a broker error is
+	 * retried on the next candle instead of immediately.
+	 *
+	 * Different assets can be updated at the same time. Only the orders
+	 * and account updates are made one at a time so that every order is
+	 * sized from an account that is up to date.
+	 */
+	void Portfolio::update_asset(Asset& asset)
+	{
+		asset.set_last_update(hirzel::sys::epoch_seconds());
+
+		// only fetches the candles the asset does not have yet
+		const char *error = _client.update_price_history(asset);
+		if (error)
+		{
+			ERROR("(%s) $%s: %s", _label, asset.ticker(), error);
+			return;
+		}
+
+		evaluate_asset(asset);
+	}
+
+	/**
+	 * Runs the strategy of an asset whose candles are up to date and
+	 * places any order it asks for.
+	 */
+	void Portfolio::evaluate_asset(Asset& asset)
+	{
+		take_action(asset, asset.update());
+	}
+
+	/**
+	 * Sets the risk of every asset from walking its strategy forward over
+	 * the stored candles of its ticker. Assets whose strategy showed no
+	 * edge out of sample risk nothing.
+	 */
+	void Portfolio::calibrate_risk(Optimizer& optimizer)
+	{
+		if (_walk_forward.in_sample == 0) return;
+
+		Result<Account> acc_res = _client.get_account();
+		if (!acc_res)
+		{
+			ERROR("(%s) $%s: %s", _label, _client.filename(), acc_res.error());
+			return;
+		}
+
+		const Account& acc = acc_res.value();
+
+		for (Asset& asset : _assets)
+		{
+			Result<Position> pos_res = _client.get_position(asset.ticker());
+			if (!pos_res)
 			{
-				// ERROR
-				ERROR("(%s) $%s: %s", _label, asset.ticker(), res.error());
+				ERROR("(%s) $%s: %s", _label, asset.ticker(), pos_res.error());
 				continue;
 			}
 
-			unsigned action = asset.update(res.get());
-
-			bool update_portfolio = false;
-
-			switch (action)
+			Result<std::shared_ptr<const CandleMap>> map_res = _client.get_stored_history(
+				asset.ticker(), asset.interval());
+			if (!map_res)
 			{
-			case ENTER_LONG:
-				_client.enter_long(asset, _risk / risk_sum());
-				update_portfolio = true;
-				break;
-
-			case EXIT_LONG:
-				_client.exit_long(asset);
-				update_portfolio = true;
-				break;
-
-			case ENTER_SHORT:
-				_client.enter_short(asset, _risk / risk_sum());
-				update_portfolio = true;
-				break;
-
-			case EXIT_SHORT:
-				_client.exit_short(asset);
-				update_portfolio = true;
-				break;
-
-			case NOTHING:
-				INFO("(%s) $%s: No action taken", _label, asset.ticker());
-				break;
-
-			case ERROR:
-				ERROR("(%s) $%s: failed to update", _label, asset.ticker());
-				_ok = false;
-				break;
-
-			default:
-				ERROR("(%s) $%s: Invalid action received from strategy: %d",
-					_label, asset.ticker(), action);
-				break;
+				ERROR("(%s) $%s: %s", _label, asset.ticker(), map_res.error());
+				continue;
 			}
 
-			// if an order was placed
-			if (update_portfolio) update();
+			SimConfig config;
+			config.principal = acc.balance();
+			config.leverage = (double)acc.leverage();
+			config.fee = pos_res.value().fee();
+			config.order_minimum = (pos_res.value().minimum() > 0.0) ? pos_res.value().minimum() : 1.0;
+			config.shorting_enabled = _shorting_enabled;
+
+			WalkForward result = optimizer.walk_forward(asset.strategy(),
+				map_res.value()->history(), config, _walk_forward);
+
+			asset.set_risk(result.risk());
+			INFO("(%s) $%s: risk set to %f after %u walk forward steps", _label,
+				asset.ticker(), asset.risk(), result.steps.size());
+		}
+	}
+
+	/**
+	 * Backtests every asset over its stored candles with one account
+	 * that starts with the balance of the client's. Orders take the same
+	 * share of the account as live ones. If no asset has had its risk
+	 * calibrated, the assets share the risk of the portfolio evenly
+	 * instead so that the backtest still trades.
+	 */
+	Result<PortfolioAccount> Portfolio::backtest()
+	{
+		Result<Account> acc_res = _client.get_account();
+		if (!acc_res) return acc_res.error();
+
+		const Account& acc = acc_res.value();
+		double sum = risk_sum();
+
+		if (sum <= 0.0)
+			WARNING("(%s) no asset risk is calibrated, backtesting with even weights", _label);
+
+		PortfolioAccount account(acc.balance(), (double)acc.leverage(), _shorting_enabled);
+		std::vector<PortfolioSeries> series;
+		// the candles are mapped for as long as these are held
+		std::vector<std::shared_ptr<const CandleMap>> maps;
+
+		series.reserve(_assets.size());
+		maps.reserve(_assets.size());
+
+		for (const Asset& asset : _assets)
+		{
+			Result<Position> pos_res = _client.get_position(asset.ticker());
+			if (!pos_res) return pos_res.error();
+
+			Result<std::shared_ptr<const CandleMap>> map_res = _client.get_stored_history(
+				asset.ticker(), asset.interval());
+			if (!map_res) return map_res.error();
+
+			const Position& pos = pos_res.value();
+			double weight = (sum > 0.0)
+				? asset.risk() * _risk / sum
+				: _risk / (double)_assets.size();
+
+			account.add_asset(pos.fee(), (pos.minimum() > 0.0) ? pos.minimum() : 1.0,
+				weight);
+			maps.push_back(map_res.get());
+
+			PortfolioSeries curr;
+			curr.strat = &asset.strategy();
+			curr.ranges = asset.ranges();
+			curr.candles = &maps.back()->history();
+			curr.window = (asset.candle_count() > 0) ? asset.candle_count() : 1;
+			series.push_back(curr);
 		}
+
+		if (!backtest_portfolio(account, series)) return "failed to backtest portfolio";
+
+		return account;
+	}
+
+	/**
+	 * Places the order that the strategy of an asset asked for
+	 */
+	void Portfolio::take_action(Asset& asset, unsigned action)
+	{
+		std::lock_guard<std::recursive_mutex> lock(*_mtx);
+		bool update_portfolio = false;
+
+		switch (action)
+		{
+		case ENTER_LONG:
+			_client.enter_long(asset, _risk / risk_sum());
+			update_portfolio = true;
+			break;
+
+		case EXIT_LONG:
+			_client.exit_long(asset);
+			update_portfolio = true;
+			break;
+
+		case ENTER_SHORT:
+			_client.enter_short(asset, _risk / risk_sum());
+			update_portfolio = true;
+			break;
+
+		case EXIT_SHORT:
+			_client.exit_short(asset);
+			update_portfolio = true;
+			break;
+
+		case NOTHING:
+			INFO("(%s) $%s: No action taken", _label, asset.ticker());
+			break;
+
+		case ERROR:
+			ERROR("(%s) $%s: failed to update", _label, asset.ticker());
+			_ok = false;
+			break;
+
+		default:
+			ERROR("(%s) $%s: Invalid action received from strategy: %d",
+				_label, asset.ticker(), action);
+			break;
+		}
+
+		// if an order was placed
+		if (update_portfolio) update();
 	}
 
 
@@ -0,0 +1,245 @@
+// header
+#include <data/portfolioaccount.h>
+
+// local includes
+#include <data/mathutil.h>
+
+// external libraries
+#include <hirzel/logger.h>
+
+namespace daytrender
+{
+	PortfolioAccount::PortfolioAccount(double principal, double leverage, bool shorting_enabled)
+	{
+		_principal = principal;
+		_balance = principal;
+		_peak_equity = principal;
+		_leverage = leverage;
+		_shorting_enabled = shorting_enabled;
+	}
+
+	/**
+	 * Adds an asset to trade with the account.
+	 *
+	 * @param	fee				fee of an order as a ratio of its price
+	 * @param	order_minimum	smallest amount of shares an order can be for
+	 * @param	weight			ratio of the account that a position can take up
+	 * @return					index of the asset in the account
+	 */
+	unsigned PortfolioAccount::add_asset(double fee, double order_minimum, double weight)
+	{
+		Holding h;
+		h.fee = fee;
+		h.order_minimum = order_minimum;
+		h.weight = weight;
+		_holdings.push_back(h);
+
+		return _holdings.size() - 1;
+	}
+
+	// multiplier is 1.0 for long positions and -1.0 for short ones
+	bool PortfolioAccount::enter(unsigned index, double multiplier)
+	{
+		Holding& h = _holdings[index];
+
+		// the opposite position is exited before entering
+		if (h.shares * multiplier < 0.0)
+		{
+			if (!close_position(index)) return false;
+		}
+
+		if (multiplier < 0.0 && !_shorting_enabled) return true;
+		if (h.weight <= 0.0 || h.price <= 0.0) return true;
+
+		double buying_power = (this->buying_power() + _margin_used) * h.weight;
+
+		// only adds to a position up to the asset's share of the account
+		if (h.shares * multiplier > 0.0) buying_power -= h.margin_used;
+		if (buying_power > this->buying_power()) buying_power = this->buying_power();
+		if (buying_power <= 0.0) return true;
+
+		double shares = get_shares_to_order(buying_power, h.price, h.order_minimum, h.fee);
+		if (shares <= 0.0) return true;
+
+		double cost = shares * h.price * (1.0 + h.fee);
+
+		_position_value -= value(h);
+		h.margin_used += cost;
+		h.shares += multiplier * shares;
+		_margin_used += cost;
+		_position_value += value(h);
+		_entrances++;
+
+		return true;
+	}
+
+	bool PortfolioAccount::exit(Holding& h, double returns)
+	{
+		_exits++;
+
+		if (returns > 0.0)
+		{
+			_win_count++;
+			_profits += returns;
+		}
+		else if (returns < 0.0)
+		{
+			_loss_count++;
+			_losses -= returns;
+		}
+
+		_position_value -= value(h);
+		_margin_used -= h.margin_used;
+		_balance += returns;
+		h.margin_used = 0.0;
+		h.shares = 0.0;
+
+		if (_balance < 0.0)
+		{
+			ERROR("resolution of exit caused balance to go negative: %f", _balance);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool PortfolioAccount::enter_long(unsigned index)
+	{
+		return enter(index, 1.0);
+	}
+
+	bool PortfolioAccount::exit_long(unsigned index)
+	{
+		Holding& h = _holdings[index];
+		if (h.shares <= 0.0) return true;
+
+		return exit(h, (h.shares * h.price * (1.0 - h.fee)) - h.margin_used);
+	}
+
+	bool PortfolioAccount::enter_short(unsigned index)
+	{
+		return enter(index, -1.0);
+	}
+
+	bool PortfolioAccount::exit_short(unsigned index)
+	{
+		Holding& h = _holdings[index];
+		if (h.shares >= 0.0) return true;
+
+		return exit(h, h.margin_used + (h.shares * h.price * (1.0 + h.fee)));
+	}
+
+	bool PortfolioAccount::close_position(unsigned index)
+	{
+		if (_holdings[index].shares > 0.0) return exit_long(index);
+		if (_holdings[index].shares < 0.0) return exit_short(index);
+		return true;
+	}
+
+	bool PortfolioAccount::close_all_positions()
+	{
+		bool success = true;
+
+		for (unsigned i = 0; i < _holdings.size(); ++i)
+		{
+			if (!close_position(i)) success = false;
+		}
+
+		return success;
+	}
+
+	void PortfolioAccount::update_price(unsigned index, double price)
+	{
+		Holding& h = _holdings[index];
+
+		// the value of a position moves with its shares for both long and short
+		_position_value += h.shares * (price - h.price);
+		h.price = price;
+	}
+
+	/**
+	 * Updates the drawdown with the current equity. It should be called
+	 * once every asset has been updated to a point in time, as equity
+	 * between those updates mixes prices of different times.
+	 */
+	void PortfolioAccount::record_equity()
+	{
+		double equity = this->equity();
+
+		if (equity > _peak_equity)
+		{
+			_peak_equity = equity;
+		}
+		else if (_peak_equity > 0.0)
+		{
+			double drawdown = (_peak_equity - equity) / _peak_equity;
+			if (drawdown > _max_drawdown) _max_drawdown = drawdown;
+		}
+	}
+
+	double PortfolioAccount::net_return() const
+	{
+		return equity() - _principal;
+	}
+
+	double PortfolioAccount::pct_return() const
+	{
+		if (_principal > 0.0)
+		{
+			return net_return() / _principal;
+		}
+		return 0.0;
+	}
+
+	double PortfolioAccount::win_rate() const
+	{
+		if (_exits > 0)
+		{
+			return (double)_win_count / (double)_exits;
+		}
+		return 0.0;
+	}
+
+	double PortfolioAccount::profit_rate() const
+	{
+		double movement = _profits + _losses;
+		if (movement > 0.0)
+		{
+			return _profits / movement;
+		}
+		return 0.0;
+	}
+
+	std::string PortfolioAccount::to_string() const
+	{
+		std::string out;
+
+		out = "PortfolioAccount:\n{";
+		out += "\n    Assets      :    " + std::to_string(_holdings.size());
+		out += "\n    Principal   :  $ " + std::to_string(_principal);
+		out += "\n    Leverage    :  x " + std::to_string(_leverage);
+		out += "\n";
+		out += "\n    Balance     :  $ " + std::to_string(_balance);
+		out += "\n    Equity      :  $ " + std::to_string(equity());
+		out += "\n    Buy Power   :  $ " + std::to_string(buying_power());
+		out += "\n";
+		out += "\n    Entrances   :    " + std::to_string(_entrances);
+		out += "\n    Exits       :    " + std::to_string(_exits);
+		out += "\n    Profits     :  $ " + std::to_string(_profits);
+		out += "\n    Losses      :  $ " + std::to_string(_losses);
+		out += "\n";
+		out += "\n    Net Return  :  $ " + std::to_string(net_return());
+		out += "\n    Pct Return  :  % " + std::to_string(pct_return() * 100.0);
+		out += "\n    Win Rate    :  % " + std::to_string(win_rate() * 100.0);
+		out += "\n    Prft Rate   :  % " + std::to_string(profit_rate() * 100.0);
+		out += "\n    Max Drawdn  :  % " + std::to_string(_max_drawdown * 100.0);
+		out += "\n}";
+		return out;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const PortfolioAccount& acc)
+	{
+		out << acc.to_string();
+		return out;
+	}
+}
@@ -1,23 +1,49 @@
 #include <data/pricehistory.h>
 
+// standard library
+#include <cstring>
+#include <utility>
+
 namespace daytrender
 {
 	PriceHistory::PriceHistory(unsigned size, unsigned interval)
 	{
+		_interval = interval;
+		allocate(size);
+	}
+
+	/**
+	 * Creates a history whose columns are allocated from an arena. Like a
+	 * view, it never frees them.
+	 */
+	PriceHistory::PriceHistory(unsigned size, unsigned interval, Arena& arena)
+	{
+		_interval = interval;
+		allocate(size, arena);
+	}
+
+	/**
+	 * Creates a view of columns that are owned by something else, like a
+	 * memory mapped file. The view never frees them.
+	 */
+	PriceHistory::PriceHistory(double* open, double* high, double* low,
+		double* close, double* volume, long long* time, unsigned size,
+		unsigned interval)
+	{
+		_slice = true;
 		_interval = interval;
 		_size = size;
-		_data = new Candle[_size];
+		_open = open;
+		_high = high;
+		_low = low;
+		_close = close;
+		_volume = volume;
+		_time = time;
 	}
 
 	PriceHistory::PriceHistory(PriceHistory&& other)
 	{
-		_data = other._data;
-		_size = other._size;
-		_interval = other._interval;
-		
-		_slice = other._slice;
-
-		other._slice = true;
+		*this = std::move(other);
 	}
 
 	PriceHistory::PriceHistory(const PriceHistory& other)
@@ -25,26 +51,89 @@ namespace daytrender
 		*this = other;
 	}
 
-	PriceHistory::PriceHistory(Candle* parent_data, unsigned parent_size,
-		unsigned parent_interval, unsigned offset, unsigned size)
+	PriceHistory::PriceHistory(const PriceHistory& parent, unsigned offset,
+		unsigned size)
 	{
 		_slice = true;
-		_interval = parent_interval;
-		_data = parent_data + offset;
+		_interval = parent._interval;
 		_size = size;
+		_open = parent._open + offset;
+		_high = parent._high + offset;
+		_low = parent._low + offset;
+		_close = parent._close + offset;
+		_volume = parent._volume + offset;
+		_time = parent._time + offset;
 	}
 
 	PriceHistory::~PriceHistory()
+	{
+		deallocate();
+	}
+
+	/**
+	 * Allocates every price column in one block and timestamps in another
+	 */
+	void PriceHistory::allocate(unsigned size)
+	{
+		_size = size;
+		_slice = false;
+
+		_open = new double[_size * 5];
+		_high = _open + _size;
+		_low = _high + _size;
+		_close = _low + _size;
+		_volume = _close + _size;
+		_time = new long long[_size];
+	}
+
+	void PriceHistory::allocate(unsigned size, Arena& arena)
+	{
+		_size = size;
+		_slice = true;
+
+		_open = arena.allocate<double>(_size * 5);
+		_high = _open + _size;
+		_low = _high + _size;
+		_close = _low + _size;
+		_volume = _close + _size;
+		_time = arena.allocate<long long>(_size);
+	}
+
+	void PriceHistory::deallocate()
 	{
 		if (!_slice)
 		{
-			delete[] _data;
+			delete[] _open;
+			delete[] _time;
 		}
+
+		_open = _high = _low = _close = _volume = nullptr;
+		_time = nullptr;
+	}
+
+	PriceHistory& PriceHistory::operator=(PriceHistory&& other)
+	{
+		deallocate();
+
+		_open = other._open;
+		_high = other._high;
+		_low = other._low;
+		_close = other._close;
+		_volume = other._volume;
+		_time = other._time;
+		_size = other._size;
+		_interval = other._interval;
+
+		_slice = other._slice;
+
+		other._slice = true;
+
+		return *this;
 	}
 
 	PriceHistory PriceHistory::slice(unsigned offset, unsigned size) const
 	{
-		if (!_data)
+		if (!_open)
 				throw std::runtime_error("data is nullptr");
 
 			if (offset > _size)
@@ -60,19 +149,53 @@ namespace daytrender
 					+ " but size is "
 					+ std::to_string(_size));
 
-			return PriceHistory(_data, _size, _interval, offset, size);
+			return PriceHistory(*this, offset, size);
+	}
+
+	/**
+	 * Copies a run of candles from another history into this one. The
+	 * other history may be this one, even if the runs overlap.
+	 * 
+	 * @param	index	where the first candle goes in this history
+	 * @param	other	history to copy from
+	 * @param	offset	index of the first candle to copy in other
+	 * @param	count	amount of candles to copy
+	 */
+	void PriceHistory::set(unsigned index, const PriceHistory& other,
+		unsigned offset, unsigned count)
+	{
+		if (count == 0) return;
+
+		check_index(index + count - 1);
+		other.check_index(offset + count - 1);
+
+		size_t bytes = count * sizeof(double);
+		std::memmove(_open + index, other._open + offset, bytes);
+		std::memmove(_high + index, other._high + offset, bytes);
+		std::memmove(_low + index, other._low + offset, bytes);
+		std::memmove(_close + index, other._close + offset, bytes);
+		std::memmove(_volume + index, other._volume + offset, bytes);
+		std::memmove(_time + index, other._time + offset, count * sizeof(long long));
 	}
 
 	PriceHistory& PriceHistory::operator=(const PriceHistory& other)
 	{
+		if (this == &other) return *this;
+
+		deallocate();
+
 		_interval = other.interval();
-		_size = other.size();
-		_data = new Candle[_size];
+		allocate(other.size());
 
-		for (int i = 0; i < _size; i++)
-		{
-			_data[i] = other.front(i);
-		}
+		if (_size == 0) return *this;
+
+		size_t bytes = _size * sizeof(double);
+		std::memcpy(_open, other._open, bytes);
+		std::memcpy(_high, other._high, bytes);
+		std::memcpy(_low, other._low, bytes);
+		std::memcpy(_close, other._close, bytes);
+		std::memcpy(_volume, other._volume, bytes);
+		std::memcpy(_time, other._time, _size * sizeof(long long));
 	
 		return *this;
 	}
@@ -3,10 +3,12 @@
 // local inlcudes
 #include <interface/backtest.h>
 #include <interface/shell.h>
+#include <util/latency.h>
 //#include <interface/server.h>
 
 // standard libararies
 #include <filesystem>
+#include <map>
 #include <thread>
 #include <mutex>
 
@@ -19,10 +21,18 @@
 using namespace hirzel;
 
 #define CONFIG_FOLDER "/config"
+// seconds between logging the latencies of the live update path
+#define LATENCY_REPORT_INTERVAL 3600
 
 namespace daytrender
 {
-	TradeSystem::TradeSystem(const std::string& dir)
+	/**
+	 * @param	dir				folder the executable and its config are in
+	 * @param	thread_count	amount of updates that can run at once, 0 for
+	 * 							one per core and 1 to run them one at a time
+	 */
+	TradeSystem::TradeSystem(const std::string& dir, unsigned thread_count) :
+	_pool(thread_count)
 	{
 		_initialized = init(dir);
 		if (!_initialized) _portfolios.clear();
@@ -98,31 +108,285 @@ namespace daytrender
 		_running = true;
 		SUCCESS("Trade system has started");
 
-		while (_running)
+		// orders are sized by the risk this measures, so it is done before trading
 		{
+			Optimizer optimizer;
+
 			for (Portfolio& portfolio : _portfolios)
 			{
+				portfolio.calibrate_risk(optimizer);
+			}
+		}
+
+		long long now = sys::epoch_seconds();
+
+		schedule_report(now + LATENCY_REPORT_INTERVAL);
+
+		for (Portfolio& portfolio : _portfolios)
+		{
+			schedule_portfolio(portfolio, now);
+
+			if (portfolio.client().is_streaming() && start_stream(portfolio)) continue;
+
+			schedule_polling(portfolio, now);
+		}
+
+		// wakes up whenever the next update is due instead of polling
+		_scheduler.run();
+
+		// waits for the streams to stop calling back
+		_streams.clear();
+
+		// batches are only started on the pool, so none start once it is idle
+		_pool.wait();
+
+		{
+			std::unique_lock<std::mutex> lock(_batch_mtx);
+			_batch_cv.wait(lock, [this]() { return _batches == 0; });
+		}
+
+		// the last batches queue their evaluations before calling back
+		_pool.wait();
+	}
+
+	// schedules the assets of a portfolio to fetch their candles every interval
+	void TradeSystem::schedule_polling(Portfolio& portfolio, long long when)
+	{
+		if (portfolio.client().is_batched())
+		{
+			// assets of the same interval are due together, so they are fetched together
+			std::map<unsigned, std::vector<Asset*>> groups;
+
+			for (Asset& asset : portfolio.assets())
+			{
+				groups[asset.interval()].push_back(&asset);
+			}
+
+			for (auto& pair : groups)
+			{
+				schedule_assets(portfolio, pair.second, when);
+			}
+
+			return;
+		}
+
+		for (Asset& asset : portfolio.assets())
+		{
+			schedule_asset(portfolio, asset, when);
+		}
+	}
+
+	/**
+	 * Streams the prices of the assets of a portfolio instead of polling
+	 * for their candles. The windows are filled once and then candles are
+	 * built out of the prices. When a candle closes, the strategy is run
+	 * on the stream's thread, which is the only one that touches the
+	 * windows, and any order is placed on the pool. If the stream fails,
+	 * the assets go back to being polled.
+	 *
+	 * @return	true if the stream started
+	 */
+	bool TradeSystem::start_stream(Portfolio& portfolio)
+	{
+		std::vector<Asset*> assets;
+		std::vector<std::string> tickers;
+
+		for (Asset& asset : portfolio.assets())
+		{
+			assets.push_back(&asset);
+			tickers.push_back(asset.ticker());
+		}
+
+		std::vector<const char*> errors = portfolio.client().update_price_histories(assets);
+
+		for (unsigned i = 0; i < assets.size(); ++i)
+		{
+			if (!errors[i]) continue;
+
+			ERROR("(%s) $%s: %s", portfolio.label(), assets[i]->ticker(), errors[i]);
+			return false;
+		}
+
+		auto on_tick = [this, &portfolio, assets](unsigned index, double price,
+			long long time)
+		{
+			Asset& asset = *assets[index];
+
+			if (!asset.candles().tick(price, time)) return;
+
+			asset.set_last_update(time);
+
+			unsigned action = asset.update();
+
+			_pool.push([this, &portfolio, &asset, action]()
+			{
+				if (!_running || !portfolio.is_live()) return;
+
+				portfolio.take_action(asset, action);
+			});
+		};
+
+		auto on_end = [this, &portfolio](const char *error)
+		{
+			ERROR("%s: price stream ended: %s", portfolio.label(), error);
+
+			if (_running) schedule_polling(portfolio, sys::epoch_seconds());
+		};
+
+		Result<std::shared_ptr<void>> res = portfolio.client().stream_prices(tickers,
+			on_tick, on_end);
+
+		if (!res)
+		{
+			ERROR("%s: failed to stream prices: %s", portfolio.label(), res.error());
+			return false;
+		}
+
+		_streams.push_back(res.get());
+
+		return true;
+	}
+
+	/**
+	 * Schedules the account update of a portfolio, which then schedules
+	 * the next one once it is done. The update runs on the pool.
+	 */
+	void TradeSystem::schedule_portfolio(Portfolio& portfolio, long long when)
+	{
+		_scheduler.schedule(when, [this, &portfolio]()
+		{
+			_pool.push([this, &portfolio]()
+			{
+				if (!_running) return;
+
+				long long now = sys::epoch_seconds();
+
 				// do nothing if portfolio is not live
 				if (!portfolio.is_live())
 				{
 					DEBUG("%s portfolio is not live and cannot be updated",
 						portfolio.label());
-					continue;
 				}
-				// update account/ pl info if hasn't been done recently
-				if (portfolio.should_update()) portfolio.update();
-				// update assets
-				portfolio.update_assets();
-			}
-			
-			// check all portfolios every 3 seconds
-			sys::sleep_millis(3000);
-		}
+				else if (portfolio.should_update())
+				{
+					portfolio.update();
+				}
+
+				// placing an order updates the account too, which moves this back
+				long long next = portfolio.next_update();
+				if (next <= now) next = now + PORTFOLIO_UPDATE_INTERVAL;
+
+				schedule_portfolio(portfolio, next);
+			});
+		});
+	}
+
+	/**
+	 * Schedules the update of an asset, which then schedules the next one
+	 * at the start of the asset's next candle. The update runs on the pool,
+	 * so assets are fetched and evaluated at the same time, and an asset
+	 * is never updated twice at once since it is only rescheduled after.
+	 */
+	void TradeSystem::schedule_asset(Portfolio& portfolio, Asset& asset,
+		long long when)
+	{
+		_scheduler.schedule(when, [this, &portfolio, &asset]()
+		{
+			_pool.push([this, &portfolio, &asset]()
+			{
+				if (!_running) return;
+
+				if (portfolio.is_live())
+				{
+					portfolio.update_asset(asset);
+				}
+				else
+				{
+					asset.set_last_update(sys::epoch_seconds());
+				}
+
+				schedule_asset(portfolio, asset, asset.next_update());
+			});
+		});
+	}
+
+	/**
+	 * Schedules the update of assets that share an interval, which then
+	 * schedules the next one at the start of their next candle. Their
+	 * candles are fetched in one request that does not hold a thread of
+	 * the pool while it waits, and once it is over the assets are
+	 * evaluated on the pool. Batches are counted until they call back so
+	 * that start() does not return while one could still use the system.
+	 */
+	void TradeSystem::schedule_assets(Portfolio& portfolio,
+		std::vector<Asset*> assets, long long when)
+	{
+		_scheduler.schedule(when, [this, &portfolio, assets]()
+		{
+			_pool.push([this, &portfolio, assets]()
+			{
+				if (!_running) return;
+
+				long long now = sys::epoch_seconds();
+
+				for (Asset *asset : assets)
+				{
+					asset->set_last_update(now);
+				}
+
+				if (!portfolio.is_live())
+				{
+					schedule_assets(portfolio, assets, assets.front()->next_update());
+					return;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(_batch_mtx);
+					_batches++;
+				}
+
+				portfolio.client().update_price_histories_async(assets,
+					[this, &portfolio, assets](const std::vector<const char*>& errors)
+				{
+					_pool.push([this, &portfolio, assets, errors]()
+					{
+						if (!_running) return;
+
+						for (unsigned i = 0; i < assets.size(); ++i)
+						{
+							if (errors[i])
+							{
+								ERROR("(%s) $%s: %s", portfolio.label(),
+									assets[i]->ticker(), errors[i]);
+								continue;
+							}
+
+							portfolio.evaluate_asset(*assets[i]);
+						}
+
+						schedule_assets(portfolio, assets, assets.front()->next_update());
+					});
+
+					std::lock_guard<std::mutex> lock(_batch_mtx);
+					if (--_batches == 0) _batch_cv.notify_all();
+				});
+			});
+		});
+	}
+
+	// logs the latencies of the session so far every interval
+	void TradeSystem::schedule_report(long long when)
+	{
+		_scheduler.schedule(when, [this, when]()
+		{
+			INFO("Latencies of this session:\n%s", latency::report());
+			schedule_report(when + LATENCY_REPORT_INTERVAL);
+		});
 	}
 
 	void TradeSystem::stop()
 	{
-		_mtx.lock();
+		std::lock_guard<std::mutex> lock(_mtx);
 		if (!_running)
 		{
 			WARNING("DayTrender has already stopped");
@@ -130,9 +394,9 @@ namespace daytrender
 		}
 
 		_running = false;
+		_scheduler.stop();
 		PRINT("\r"); // covering up ^C from interrupt
 		INFO("Shutting down trade system...");
-		_mtx.unlock();
 	}
 
 	Portfolio *TradeSystem::get_portfolio(const std::string& label)
@@ -1,10 +1,15 @@
 // local includes
 #include <data/tradesystem.h>
+#include <util/latency.h>
 
 // standard library
+#include <cerrno>
 #include <cstring>
 #include <csignal>
 #include <filesystem>
+#include <thread>
+
+#include <unistd.h>
 
 // external libraries
 #include <hirzel/logger.h>
@@ -65,9 +70,9 @@ bool cli_account(TradeSystem& system, int argc, const char *args[], const char *
 
 bool cli_backtest(TradeSystem& system, int argc, const char *args[], const char *dir)
 {
-	if (argc != 2)
+	if (argc != 1 && argc != 2)
 	{
-		command_error("backtest <portfolio> <ticker>");
+		command_error("backtest <portfolio> [ticker]");
 		return false;
 	}
 
@@ -76,6 +81,24 @@ bool cli_backtest(TradeSystem& system, int argc, const char *args[], const char
 	Portfolio *portfolio = system.get_portfolio(label);
 	if (!portfolio) return portfolio_error();
 
+	// every asset of the portfolio on one account
+	if (argc == 1)
+	{
+		// sizes orders the same as when the trade system starts
+		Optimizer optimizer;
+		portfolio->calibrate_risk(optimizer);
+
+		Result<PortfolioAccount> res = portfolio->backtest();
+		if (!res)
+		{
+			ERROR("%s: %s", label, res.error());
+			return false;
+		}
+
+		PRINT("%s\n", res.value().to_string());
+		return true;
+	}
+
 	// 
 
 
@@ -141,12 +164,14 @@ bool handle_input(TradeSystem& system, int argc, const char *args[], const char
 	return false;
 }
 
-daytrender::TradeSystem *system_ref = nullptr;
+// interrupts are written to this since stopping the system is not safe in a signal handler
+int interrupt_pipe[2] = { -1, -1 };
 
 void interrupt(int signal)
 {
-	if (!system_ref) exit(signal);
-	system_ref->stop();
+	char byte = 0;
+	ssize_t written = write(interrupt_pipe[1], &byte, 1);
+	(void)written;
 }
 
 int main(int argc, const char *argv[])
@@ -162,7 +187,6 @@ int main(int argc, const char *argv[])
 
 	// initializing trade system
 	daytrender::TradeSystem system(dir);
-	system_ref = &system;
 
 	if (!system.is_initialized())
 	{
@@ -175,11 +199,30 @@ int main(int argc, const char *argv[])
 	if (command_line) return !handle_input(system, argc - 1, argv + 1, dir.c_str());
 
 	// setting up handler for keyboard interrupts
+	if (pipe(interrupt_pipe) != 0)
+	{
+		FATAL("failed to create interrupt pipe");
+		return 1;
+	}
+
 	std::signal(SIGINT, interrupt);
 
+	// stops the system once interrupted, outside of the signal handler
+	std::thread watcher([&system]()
+	{
+		char byte;
+		while (read(interrupt_pipe[0], &byte, 1) < 0 && errno == EINTR);
+		if (system.is_running()) system.stop();
+	});
+
 	// returns when program has ended
 	system.start();
 
+	// wakes the watcher in case the system stopped without an interrupt
+	interrupt(SIGINT);
+	watcher.join();
+
+	INFO("Latencies of this session:\n%s", latency::report());
 	SUCCESS("DayTrender has stopped");
 	return 0;
 }
\ No newline at end of file
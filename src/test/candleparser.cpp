@@ -0,0 +1,143 @@
+// local includes
+#include <api/candleparser.h>
+#include <data/pricehistory.h>
+
+// standard library
+#include <assert.h>
+#include <stdio.h>
+
+#include <string>
+
+using namespace daytrender;
+
+// response of oanda with two complete candles and one that is still open
+const std::string oanda_json = R"({
+	"instrument": "EUR_USD",
+	"granularity": "M1",
+	"candles": [
+		{ "complete": true, "volume": 12, "time": "1627300020.000000000",
+			"mid": { "o": "1.17950", "h": "1.17960", "l": "1.17940", "c": "1.17955" } },
+		{ "complete": true, "volume": 7, "time": "1627300080.000000000",
+			"mid": { "o": "1.17955", "h": "1.17970", "l": "1.17950", "c": "1.17965" } },
+		{ "complete": false, "volume": 3, "time": "1627300140.000000000",
+			"mid": { "o": "1.17965", "h": "1.17965", "l": "1.17930", "c": "1.17935" } }
+	]
+})";
+
+// reads every candle of a response into a history of the same size
+static const char *parse(const std::string& json, PriceHistory& hist)
+{
+	CandleParser parser(json);
+	unsigned count;
+
+	const char *err = parser.find_candles();
+	if (err) return err;
+
+	err = parser.count(count);
+	if (err) return err;
+
+	hist = PriceHistory(count, 60);
+	return parser.read(hist, 0, count);
+}
+
+static void test_oanda()
+{
+	PriceHistory hist;
+	assert(parse(oanda_json, hist) == nullptr);
+	assert(hist.size() == 3);
+
+	assert(hist[0].open() == 1.17950);
+	assert(hist[0].high() == 1.17960);
+	assert(hist[0].low() == 1.17940);
+	assert(hist[0].close() == 1.17955);
+	assert(hist[0].volume() == 12.0);
+	assert(hist.timestamp(0) == 1627300020);
+
+	assert(hist[2].close() == 1.17935);
+	assert(hist[2].volume() == 3.0);
+	assert(hist.timestamp(2) == 1627300140);
+}
+
+static void test_skip()
+{
+	CandleParser parser(oanda_json);
+	unsigned count;
+
+	assert(parser.find_candles() == nullptr);
+	assert(parser.count(count) == nullptr);
+	assert(count == 3);
+
+	// the newest two, like when the older ones are already stored
+	PriceHistory hist(2, 60);
+	assert(parser.read(hist, 1, 2) == nullptr);
+	assert(hist[0].open() == 1.17955);
+	assert(hist.timestamp(0) == 1627300080);
+	assert(hist[1].open() == 1.17965);
+	assert(hist.timestamp(1) == 1627300140);
+
+	// the history has to fit the candles
+	PriceHistory small(1, 60);
+	assert(parser.read(small, 0, 2) != nullptr);
+
+	// asking for more candles than were received
+	PriceHistory large(4, 60);
+	assert(parser.read(large, 0, 4) != nullptr);
+}
+
+static void test_layout()
+{
+	// unquoted numbers, keys in any order, other prices next to mid and
+	// values that have to be skipped over, including escaped quotes
+	std::string json = "{\"note\":\"say \\\"hi\\\" ]}\",\"nested\":{\"a\":[1,{\"b\":[]}]},"
+		"\"candles\":[{\"mid\":{\"c\":-2.5e1,\"x\":[1,2],\"o\":1e-3,\"h\":3,\"l\":-4},"
+		"\"bid\":{\"o\":\"9\",\"h\":\"9\",\"l\":\"9\",\"c\":\"9\"},"
+		"\"time\":1627300000,\"complete\":null,\"volume\":\"5\"},{}]}";
+
+	PriceHistory hist;
+	assert(parse(json, hist) == nullptr);
+	assert(hist.size() == 2);
+
+	assert(hist[0].open() == 0.001);
+	assert(hist[0].high() == 3.0);
+	assert(hist[0].low() == -4.0);
+	assert(hist[0].close() == -25.0);
+	assert(hist[0].volume() == 5.0);
+	assert(hist.timestamp(0) == 1627300000);
+
+	// missing values read as 0
+	assert(hist[1].open() == 0.0);
+	assert(hist[1].close() == 0.0);
+	assert(hist.timestamp(1) == 0);
+}
+
+static void test_errors()
+{
+	PriceHistory hist;
+
+	// no candles
+	assert(parse("{\"candles\":[]}", hist) == nullptr);
+	assert(hist.size() == 0);
+	assert(parse("{}", hist) != nullptr);
+	assert(parse("{\"errorMessage\":\"Invalid value specified for 'granularity'\"}", hist) != nullptr);
+	assert(parse("{\"candles\":null}", hist) != nullptr);
+
+	// not json or cut short
+	assert(parse("", hist) != nullptr);
+	assert(parse("<html></html>", hist) != nullptr);
+	assert(parse("[]", hist) != nullptr);
+	assert(parse(oanda_json.substr(0, oanda_json.size() / 2), hist) != nullptr);
+	assert(parse("{\"candles\":[{\"mid\":{\"o\":\"1.0", hist) != nullptr);
+	assert(parse("{\"candles\":[{\"mid\":{\"o\":\"1.0\"}}", hist) != nullptr);
+	assert(parse("{\"candles\":[{\"mid\":{\"o\":\"abc\"}}]}", hist) != nullptr);
+	assert(parse("{\"candles\":[{\"time\" 1}]}", hist) != nullptr);
+}
+
+int main(void)
+{
+	test_oanda();
+	test_skip();
+	test_layout();
+	test_errors();
+	puts("Candles are parsed correctly");
+	return 0;
+}
@@ -0,0 +1,175 @@
+// local includes
+#include <data/candlewindow.h>
+#include <data/pricehistory.h>
+
+// standard library
+#include <assert.h>
+#include <stdio.h>
+
+#include <stdexcept>
+#include <utility>
+
+using namespace daytrender;
+
+// candle whose prices are all the number it was pushed as
+static Candle numbered(unsigned n)
+{
+	return Candle(n, n + 0.5, n - 0.5, n + 0.25, n);
+}
+
+// checks that a window holds candles first to last, from oldest to newest
+static void check_order(const CandleWindow& window, unsigned first, unsigned last)
+{
+	unsigned size = last - first + 1;
+	assert(window.size() == size);
+	assert(window.front().open() == first);
+	assert(window.back().open() == last);
+	assert(window.back_timestamp() == (long long)last * 60);
+
+	PriceHistory view = window.view();
+	assert(view.size() == size);
+	assert(view.interval() == 60);
+
+	for (unsigned i = 0; i < size; ++i)
+	{
+		Candle c = numbered(first + i);
+
+		assert(window[i].open() == c.open());
+		assert(window[i].close() == c.close());
+		assert(window.back(size - 1 - i).open() == c.open());
+
+		// the view is one contiguous run however far the ring has wrapped
+		assert(view.opens()[i] == c.open());
+		assert(view.highs()[i] == c.high());
+		assert(view.lows()[i] == c.low());
+		assert(view.closes()[i] == c.close());
+		assert(view.volumes()[i] == c.volume());
+		assert(view.timestamps()[i] == (long long)(first + i) * 60);
+	}
+}
+
+static void test_wrap()
+{
+	CandleWindow window(5, 60);
+	assert(window.empty());
+	assert(window.view().size() == 0);
+
+	for (unsigned n = 1; n <= 23; ++n)
+	{
+		window.push(numbered(n), (long long)n * 60);
+		check_order(window, (n > 5) ? n - 4 : 1, n);
+		assert(window.full() == (n >= 5));
+	}
+
+	// replacing the newest candle where the ring has wrapped
+	window.set_back(numbered(99), 23 * 60);
+	assert(window.back().open() == 99.0);
+	assert(window.view().closes()[4] == numbered(99).close());
+	assert(window.front().open() == 19.0);
+
+	bool threw = false;
+	try
+	{
+		window.get(5);
+	}
+	catch (const std::out_of_range&)
+	{
+		threw = true;
+	}
+	assert(threw);
+
+	window.clear();
+	assert(window.empty());
+	assert(window.view().size() == 0);
+}
+
+static void test_assign()
+{
+	PriceHistory hist(8, 60);
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		hist.set(i, numbered(i + 1), (long long)(i + 1) * 60);
+	}
+
+	// only the newest candles fit
+	CandleWindow window(5, 60);
+	window.push(numbered(50), 50 * 60);
+	window.assign(hist);
+	check_order(window, 4, 8);
+
+	// fewer candles than the capacity
+	CandleWindow large(20, 60);
+	large.assign(hist);
+	check_order(large, 1, 8);
+
+	// copies and moves keep where the ring is
+	CandleWindow copy(window);
+	check_order(copy, 4, 8);
+	copy.push(numbered(9), 9 * 60);
+	check_order(copy, 5, 9);
+	check_order(window, 4, 8);
+
+	CandleWindow moved(std::move(copy));
+	check_order(moved, 5, 9);
+	assert(copy.size() == 0);
+	assert(copy.view().size() == 0);
+
+	large = moved;
+	check_order(large, 5, 9);
+	assert(large.capacity() == 5);
+
+	// a window without capacity holds nothing
+	CandleWindow none(0, 60);
+	none.push(numbered(1), 60);
+	assert(none.empty());
+	assert(none.view().size() == 0);
+}
+
+static void test_tick()
+{
+	CandleWindow window(3, 60);
+
+	// nothing to line up with yet
+	assert(!window.tick(1.0, 100));
+	assert(window.empty());
+
+	window.push(Candle(10.0, 10.0, 10.0, 10.0, 1.0), 120);
+
+	// folded into the newest candle
+	assert(!window.tick(12.0, 150));
+	assert(!window.tick(9.0, 179));
+	assert(window.size() == 1);
+	assert(window.back().open() == 10.0);
+	assert(window.back().high() == 12.0);
+	assert(window.back().low() == 9.0);
+	assert(window.back().close() == 9.0);
+	assert(window.back().volume() == 3.0);
+
+	// from before the newest candle
+	assert(!window.tick(50.0, 119));
+	assert(window.back().high() == 12.0);
+
+	// a gap still lines up with the candles before it
+	assert(window.tick(11.0, 310));
+	assert(window.size() == 2);
+	assert(window.back_timestamp() == 300);
+	assert(window.back().open() == 11.0);
+	assert(window.back().volume() == 1.0);
+
+	// new candles keep wrapping the ring
+	assert(window.tick(13.0, 360));
+	assert(window.tick(14.0, 420));
+	assert(window.size() == 3);
+	assert(window.front().open() == 11.0);
+	assert(window.view().timestamps()[0] == 300);
+	assert(window.view().timestamps()[2] == 420);
+}
+
+int main(void)
+{
+	test_wrap();
+	test_assign();
+	test_tick();
+	puts("Candle windows wrap around correctly");
+	return 0;
+}
@@ -0,0 +1,415 @@
+// local includes
+#include <data/indicator.h>
+#include <data/pricehistory.h>
+#include <util/indicators.h>
+
+// standard library
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace daytrender;
+
+typedef void (*Kernel)(Indicator&, const PriceHistory&, unsigned);
+typedef std::vector<double> (*Reference)(const PriceHistory&, unsigned);
+
+// random walk with flat stretches so oscillators hit their midpoint
+static PriceHistory make_history(unsigned size, unsigned seed)
+{
+	PriceHistory hist(size, 60);
+	std::mt19937_64 rng(seed);
+	std::normal_distribution<double> step(0.0, 0.01);
+	std::uniform_real_distribution<double> wick(0.0, 0.005);
+	double price = 100.0;
+
+	for (unsigned i = 0; i < size; ++i)
+	{
+		double open = price;
+		bool flat = (i / 7) % 5 == 3;
+
+		if (!flat) price *= exp(step(rng));
+
+		double high = flat ? price : std::max(open, price) * (1.0 + wick(rng));
+		double low = flat ? price : std::min(open, price) * (1.0 - wick(rng));
+
+		hist.set(i, Candle(open, high, low, price, 100.0), (long long)i * 60);
+	}
+
+	return hist;
+}
+
+// first candle of the window ending on i
+static unsigned first(unsigned i, unsigned range)
+{
+	return (i + 1 > range) ? i + 1 - range : 0;
+}
+
+static std::vector<double> closes(const PriceHistory& hist)
+{
+	return std::vector<double>(hist.closes(), hist.closes() + hist.size());
+}
+
+// NAIVE REFERENCES	========================================================
+// each gives the value at every candle of the history
+
+static std::vector<double> naive_mean(const std::vector<double>& x, unsigned range)
+{
+	std::vector<double> out(x.size());
+
+	for (unsigned i = 0; i < x.size(); ++i)
+	{
+		double sum = 0.0;
+		for (unsigned j = first(i, range); j <= i; ++j) sum += x[j];
+		out[i] = sum / (double)(i + 1 - first(i, range));
+	}
+
+	return out;
+}
+
+// smoothing that starts from the window mean at the start candle
+static std::vector<double> naive_smooth(const std::vector<double>& x, unsigned start,
+	unsigned range, double alpha)
+{
+	std::vector<double> out(x.size(), 0.0);
+	out[start] = naive_mean(x, range)[start];
+
+	for (unsigned i = start + 1; i < x.size(); ++i)
+	{
+		out[i] = x[i] * alpha + out[i - 1] * (1.0 - alpha);
+	}
+
+	return out;
+}
+
+static std::vector<double> naive_sma(const PriceHistory& hist, unsigned range)
+{
+	return naive_mean(closes(hist), range);
+}
+
+static std::vector<double> naive_wma(const PriceHistory& hist, unsigned range)
+{
+	std::vector<double> out(hist.size());
+
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		double sum = 0.0;
+		double weights = 0.0;
+
+		for (unsigned j = first(i, range); j <= i; ++j)
+		{
+			double weight = (double)(j - first(i, range) + 1);
+			sum += weight * hist[j].close();
+			weights += weight;
+		}
+
+		out[i] = sum / weights;
+	}
+
+	return out;
+}
+
+static std::vector<double> naive_stddev(const PriceHistory& hist, unsigned range,
+	double deviations)
+{
+	std::vector<double> mean = naive_sma(hist, range);
+	std::vector<double> out(hist.size());
+
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		double sum = 0.0;
+		for (unsigned j = first(i, range); j <= i; ++j)
+		{
+			double d = hist[j].close() - mean[i];
+			sum += d * d;
+		}
+
+		out[i] = mean[i] + deviations * sqrt(sum / (double)(i + 1 - first(i, range)));
+	}
+
+	return out;
+}
+
+static std::vector<double> naive_bollinger_upper(const PriceHistory& hist, unsigned range)
+{
+	return naive_stddev(hist, range, 2.0);
+}
+
+static std::vector<double> naive_bollinger_lower(const PriceHistory& hist, unsigned range)
+{
+	return naive_stddev(hist, range, -2.0);
+}
+
+static std::vector<double> naive_extreme(const PriceHistory& hist, unsigned range,
+	const double* x, bool highest)
+{
+	std::vector<double> out(hist.size());
+
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		out[i] = x[i];
+		for (unsigned j = first(i, range); j <= i; ++j)
+		{
+			out[i] = highest ? std::max(out[i], x[j]) : std::min(out[i], x[j]);
+		}
+	}
+
+	return out;
+}
+
+static std::vector<double> naive_rolling_min(const PriceHistory& hist, unsigned range)
+{
+	return naive_extreme(hist, range, hist.closes(), false);
+}
+
+static std::vector<double> naive_rolling_max(const PriceHistory& hist, unsigned range)
+{
+	return naive_extreme(hist, range, hist.closes(), true);
+}
+
+static std::vector<double> naive_stochastic(const PriceHistory& hist, unsigned range)
+{
+	std::vector<double> lowest = naive_extreme(hist, range, hist.lows(), false);
+	std::vector<double> highest = naive_extreme(hist, range, hist.highs(), true);
+	std::vector<double> out(hist.size());
+
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		out[i] = (highest[i] == lowest[i])
+			? 50.0
+			: (hist[i].close() - lowest[i]) / (highest[i] - lowest[i]) * 100.0;
+	}
+
+	return out;
+}
+
+// SMOOTHED REFERENCES	====================================================
+// these depend on where the smoothing starts, so they take the indicator size
+
+static std::vector<double> naive_ema(const PriceHistory& hist, unsigned range,
+	unsigned size)
+{
+	return naive_smooth(closes(hist), hist.size() - size, range, 2.0 / (double)(range + 1));
+}
+
+static std::vector<double> naive_macd(const PriceHistory& hist, unsigned range,
+	unsigned size)
+{
+	unsigned slow_range = std::max(range * 26 / 12, range + 1);
+	std::vector<double> fast = naive_ema(hist, range, size);
+	std::vector<double> slow = naive_ema(hist, slow_range, size);
+
+	for (unsigned i = 0; i < fast.size(); ++i) fast[i] -= slow[i];
+
+	return fast;
+}
+
+static std::vector<double> naive_atr(const PriceHistory& hist, unsigned range,
+	unsigned size)
+{
+	std::vector<double> tr(hist.size());
+
+	for (unsigned i = 0; i < hist.size(); ++i)
+	{
+		double high = hist[i].high();
+		double low = hist[i].low();
+		tr[i] = high - low;
+
+		if (i > 0)
+		{
+			double prev = hist[i - 1].close();
+			tr[i] = std::max(tr[i], std::max(fabs(high - prev), fabs(low - prev)));
+		}
+	}
+
+	return naive_smooth(tr, hist.size() - size, range, 1.0 / (double)range);
+}
+
+static std::vector<double> naive_rsi(const PriceHistory& hist, unsigned range,
+	unsigned size)
+{
+	std::vector<double> out(hist.size(), 50.0);
+	unsigned start = hist.size() - size;
+
+	// the first candle has no change
+	if (start == 0) start = 1;
+	if (start >= hist.size()) return out;
+
+	// movement into candle i + 1
+	std::vector<double> gain(hist.size() - 1);
+	std::vector<double> loss(hist.size() - 1);
+
+	for (unsigned i = 0; i + 1 < hist.size(); ++i)
+	{
+		double change = hist[i + 1].close() - hist[i].close();
+		gain[i] = std::max(change, 0.0);
+		loss[i] = std::max(-change, 0.0);
+	}
+
+	std::vector<double> avg_gain = naive_smooth(gain, start - 1, range, 1.0 / (double)range);
+	std::vector<double> avg_loss = naive_smooth(loss, start - 1, range, 1.0 / (double)range);
+
+	for (unsigned i = start; i < hist.size(); ++i)
+	{
+		double g = avg_gain[i - 1];
+		double l = avg_loss[i - 1];
+		out[i] = (g + l == 0.0) ? 50.0 : 100.0 * g / (g + l);
+	}
+
+	return out;
+}
+
+// CHECKS	================================================================
+
+static bool close_to(double a, double b, double tolerance)
+{
+	return fabs(a - b) <= tolerance * std::max(1.0, std::max(fabs(a), fabs(b)));
+}
+
+static void check(const char *name, const Indicator& data, const std::vector<double>& expected,
+	double tolerance = 1e-9)
+{
+	unsigned offset = expected.size() - data.size();
+
+	for (unsigned i = 0; i < data.size(); ++i)
+	{
+		if (!close_to(data[i], expected[offset + i], tolerance))
+		{
+			fprintf(stderr, "%s: value %u is %.12f but should be %.12f\n", name, i,
+				data[i], expected[offset + i]);
+			assert(false);
+		}
+	}
+}
+
+struct Plain
+{
+	const char *name;
+	Kernel kernel;
+	Reference reference;
+	double tolerance;
+};
+
+struct Smoothed
+{
+	const char *name;
+	Kernel kernel;
+	std::vector<double> (*reference)(const PriceHistory&, unsigned, unsigned);
+};
+
+const Plain plain[] =
+{
+	{ "sma", indicators::sma, naive_sma, 1e-9 },
+	{ "wma", indicators::wma, naive_wma, 1e-9 },
+	// variances are differences of running sums, so a flat window is only
+	// zero to about the square root of their rounding
+	{ "bollinger_upper", indicators::bollinger_upper, naive_bollinger_upper, 1e-6 },
+	{ "bollinger_lower", indicators::bollinger_lower, naive_bollinger_lower, 1e-6 },
+	{ "stochastic", indicators::stochastic, naive_stochastic, 1e-9 },
+	{ "rolling_min", indicators::rolling_min, naive_rolling_min, 1e-9 },
+	{ "rolling_max", indicators::rolling_max, naive_rolling_max, 1e-9 }
+};
+
+const Smoothed smoothed[] =
+{
+	{ "ema", indicators::ema, naive_ema },
+	{ "macd", indicators::macd, naive_macd },
+	{ "atr", indicators::atr, naive_atr },
+	{ "rsi", indicators::rsi, naive_rsi }
+};
+
+static void test_kernels()
+{
+	// odd sizes and ranges so the vector tails and cut short windows are hit
+	const unsigned sizes[] = { 1, 2, 5, 37, 250 };
+	const unsigned ranges[] = { 0, 1, 2, 3, 9, 20, 300 };
+
+	for (unsigned size : sizes)
+	{
+		PriceHistory hist = make_history(size, size);
+
+		// indicators covering all, most and the last of the candles
+		unsigned lengths[] = { size, size - size / 3, 1 };
+
+		for (unsigned length : lengths)
+		{
+			for (unsigned range : ranges)
+			{
+				Indicator data(length);
+				unsigned r = range ? range : 1;
+
+				for (const Plain& p : plain)
+				{
+					p.kernel(data, hist, range);
+					check(p.name, data, p.reference(hist, r), p.tolerance);
+				}
+
+				for (const Smoothed& s : smoothed)
+				{
+					s.kernel(data, hist, range);
+					check(s.name, data, s.reference(hist, r, length));
+				}
+			}
+		}
+	}
+}
+
+static void test_batch()
+{
+	PriceHistory hist = make_history(101, 7);
+
+	// enough ranges for full batches, half batches and single leftovers
+	for (unsigned count = 1; count <= 21; ++count)
+	{
+		std::vector<Indicator> batch;
+		std::vector<Indicator*> data;
+		std::vector<unsigned> ranges;
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			// runs of equal sizes broken up by ones that differ
+			unsigned length = (i % 6 == 5) ? 50 : 90;
+			batch.emplace_back(length);
+			ranges.push_back(i * 3);
+		}
+
+		// ones that are too long are left alone
+		if (count > 10)
+		{
+			batch[10] = Indicator(102);
+			batch[10][0] = -1.0;
+		}
+
+		for (Indicator& i : batch) data.push_back(&i);
+
+		indicators::batch::ema(data.data(), hist, ranges.data(), count);
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (batch[i].size() > hist.size())
+			{
+				assert(batch[i][0] == -1.0);
+				continue;
+			}
+
+			Indicator scalar(batch[i].size());
+			indicators::ema(scalar, hist, ranges[i]);
+
+			std::vector<double> expected(scalar.size());
+			for (unsigned j = 0; j < scalar.size(); ++j) expected[j] = scalar[j];
+
+			check("batch ema", batch[i], expected, 1e-12);
+		}
+	}
+}
+
+int main(void)
+{
+	test_kernels();
+	test_batch();
+	puts("Indicator kernels match their references");
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <util/arena.h>
+
+// standard library
+#include <cstdint>
+#include <new>
+
+namespace daytrender
+{
+	/**
+	 * @param	block_size	size of every block unless an allocation needs more
+	 */
+	Arena::Arena(size_t block_size)
+	{
+		_block_size = (block_size > 0) ? block_size : 1;
+	}
+
+	Arena::~Arena()
+	{
+		for (Block& block : _blocks)
+		{
+			::operator delete(block.data);
+		}
+	}
+
+	// puts a new block after the current one so later blocks are kept for reuse
+	void Arena::add_block(size_t size)
+	{
+		Block block = { (char*)::operator new(size), size };
+		size_t index = _blocks.empty() ? 0 : _current + 1;
+
+		_blocks.insert(_blocks.begin() + index, block);
+		_current = index;
+		_used = 0;
+	}
+
+	/**
+	 * Gets memory from the current block, moving on to the next one when
+	 * it does not fit. A block is only allocated when none of the ones
+	 * after the current one can hold the request.
+	 *
+	 * @param	bytes	size of the allocation
+	 * @param	align	alignment of the allocation, must be a power of two
+	 * @return			pointer to the memory
+	 */
+	void* Arena::allocate(size_t bytes, size_t align)
+	{
+		if (bytes == 0) bytes = 1;
+
+		while (!_blocks.empty())
+		{
+			Block& block = _blocks[_current];
+			uintptr_t base = (uintptr_t)block.data;
+			uintptr_t start = (base + _used + (align - 1)) & ~(uintptr_t)(align - 1);
+			size_t end = (start - base) + bytes;
+
+			if (end <= block.size)
+			{
+				_used = end;
+				return (void*)start;
+			}
+
+			if (_current + 1 == _blocks.size()) break;
+
+			_current++;
+			_used = 0;
+		}
+
+		size_t size = bytes + align;
+		add_block((size > _block_size) ? size : _block_size);
+
+		return allocate(bytes, align);
+	}
+
+	/**
+	 * Releases everything that was allocated after the mark. The blocks are
+	 * kept so the next allocations do not have to allocate again.
+	 */
+	void Arena::rewind(const Mark& mark)
+	{
+		if (_blocks.empty()) return;
+
+		_current = mark.block;
+		_used = mark.used;
+	}
+
+	/**
+	 * Releases everything in the arena. If it grew past one block, the
+	 * blocks are replaced by a single one that can hold all of them, so an
+	 * arena that is reset between ticks or backtests settles on one block
+	 * and then stops allocating.
+	 */
+	void Arena::reset()
+	{
+		_current = 0;
+		_used = 0;
+
+		if (_blocks.size() < 2) return;
+
+		size_t total = capacity();
+
+		for (Block& block : _blocks)
+		{
+			::operator delete(block.data);
+		}
+
+		_blocks.clear();
+		add_block(total);
+	}
+
+	size_t Arena::capacity() const
+	{
+		size_t total = 0;
+
+		for (const Block& block : _blocks)
+		{
+			total += block.size;
+		}
+
+		return total;
+	}
+
+	/**
+	 * Scratch arena of the calling thread. Every shared library that is
+	 * built with this file, like a strategy plugin, has its own.
+	 */
+	Arena& Arena::local()
+	{
+		static thread_local Arena arena;
+		return arena;
+	}
+}
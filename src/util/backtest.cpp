@@ -1,6 +1,11 @@
 #include <interface/backtest.h>
 
+// local includes
+#include <data/candlewindow.h>
+#include <util/arena.h>
+
 // standard libarary
+#include <algorithm>
 // #include <future>
 // #include <chrono>
 
@@ -14,27 +19,41 @@
 
 namespace daytrender
 {
-	bool backtest_permutation(PaperAccount& acc, const Asset& asset,
-		const PriceHistory& candles, const Strategy *strat,
-		const std::vector<unsigned>& ranges)
+	/**
+	 * Simulates trading an asset over a history with a paper account. The
+	 * strategy is run over the whole history at once so that indicators
+	 * are carried forward from candle to candle instead of being
+	 * recalculated for every window.
+	 * 
+	 * @param	acc		account to simulate the orders with
+	 * @param	candles	history to test over
+	 * @param	strat	strategy to get actions from
+	 * @param	ranges	ranges of the strategy's indicators
+	 * @param	window	amount of candles the strategy sees at a time
+	 * @return			false if the strategy or an order failed
+	 */
+	bool backtest_permutation(PaperAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window)
 	{
-		for (long i = 0; i < candles.size() - asset.candle_count(); i++)
-		{
-			PriceHistory slice = candles.slice(i, asset.candle_count());
+		Arena::Scope scope(Arena::local());
+		Chart chart(Arena::local());
+		std::vector<short> actions;
 
-			acc.update_price(slice.back().close());
-			Result<Chart> res = strat->execute(slice, asset.ranges());
-
-			if (!res)
-			{
-				ERROR("Backtest: Strategy: %s", res.error());
-				return false;
-			}
+		return backtest_permutation(acc, candles, strat, ranges, window, chart,
+			actions);
+	}
 
-			Chart data = res.get();
+	// trades with any account that takes the orders of a PaperAccount
+	template <typename Account>
+	static bool trade(Account& acc, const PriceHistory& candles,
+		const short *actions, unsigned first, unsigned last)
+	{
+		for (unsigned i = first; i < last; i++)
+		{
+			acc.update_price(candles[i].close());
 
 			bool success = true;
-			switch (data.action())
+			switch (actions[i])
 			{
 			case NOTHING:
 				break;
@@ -46,17 +65,21 @@ namespace daytrender
 				break;
 			case ENTER_SHORT:
 				success = acc.enter_short();
+				break;
 			case EXIT_SHORT:
 				success = acc.exit_short();
+				break;
 			case ERROR:
 				return false;
 			default:
 				ERROR("Invalid action received from strategy");
 				return false;
 			}
+
 			if (!success)
 			{
-				
+				ERROR("Backtest: order failed at candle %u", i);
+				return false;
 			}
 		}
 		
@@ -65,6 +88,389 @@ namespace daytrender
 		return true;
 	}
 
+	template <typename Account>
+	static bool simulate(Account& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window,
+		Chart& chart, std::vector<short>& actions)
+	{
+		if (candles.size() < window)
+		{
+			ERROR("Backtest: %u candles were given but at least %u are required",
+				candles.size(), window);
+			return false;
+		}
+
+		try
+		{
+			strat->execute_series(chart, actions, candles, ranges, window);
+		}
+		catch (const std::string& err)
+		{
+			ERROR("Backtest: Strategy: %s", err);
+			return false;
+		}
+
+		return trade(acc, candles, actions.data(), window - 1, candles.size());
+	}
+
+	/**
+	 * Trades actions that were already taken by a strategy over part of a
+	 * history and closes the position at the end of it. Actions of a whole
+	 * history can be traded over any of its windows this way without
+	 * running the strategy again.
+	 * 
+	 * @param	acc		account to simulate the orders with
+	 * @param	candles	history that the actions were taken over
+	 * @param	actions	action at every candle of the history
+	 * @param	first	first candle to trade at
+	 * @param	last	candle after the last one to trade at
+	 * @return			false if an action was an error or an order failed
+	 */
+	bool backtest_actions(PaperAccount& acc, const PriceHistory& candles,
+		const short *actions, unsigned first, unsigned last)
+	{
+		return trade(acc, candles, actions, first, last);
+	}
+
+	bool backtest_actions(SimAccount& acc, const PriceHistory& candles,
+		const short *actions, unsigned first, unsigned last)
+	{
+		if (trade(acc, candles, actions, first, last)) return true;
+
+		acc.fail();
+		return false;
+	}
+
+	/**
+	 * Same as the first backtest_permutation but with a chart and action
+	 * buffer that are reused, so a worker running many permutations only
+	 * allocates for its first.
+	 */
+	bool backtest_permutation(PaperAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window,
+		Chart& chart, std::vector<short>& actions)
+	{
+		return simulate(acc, candles, strat, ranges, window, chart, actions);
+	}
+
+	/**
+	 * Backtests a permutation of a sweep with a compact account. It trades
+	 * the same as with a PaperAccount, so running the best permutations
+	 * again with one gives their full statistics. The account is marked as
+	 * failed if this returns false.
+	 */
+	bool backtest_permutation(SimAccount& acc, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<unsigned>& ranges, unsigned window,
+		Chart& chart, std::vector<short>& actions)
+	{
+		if (simulate(acc, candles, strat, ranges, window, chart, actions)) return true;
+
+		acc.fail();
+		return false;
+	}
+
+	/**
+	 * Backtests several permutations of a sweep in one pass over the
+	 * candles. The strategy is run for every set of ranges at once, and
+	 * then every account takes its action at a candle before moving on to
+	 * the next, so the candles are only read once for the whole batch.
+	 * An account whose order fails or whose strategy gives an error stops
+	 * trading and is marked as failed.
+	 * 
+	 * @param	accounts	account of every permutation, in the order of ranges
+	 * @param	candles		history to test over
+	 * @param	strat		strategy to get actions from
+	 * @param	ranges		ranges of the indicators of every permutation
+	 * @param	window		amount of candles the strategy sees at a time
+	 * @param	charts		workspace that is reused between batches
+	 * @param	actions		workspace that is reused between batches
+	 * @return				false if the strategy could not be run
+	 */
+	bool backtest_batch(std::vector<SimAccount>& accounts, const PriceHistory& candles,
+		const Strategy *strat, const std::vector<std::vector<unsigned>>& ranges,
+		unsigned window, std::vector<Chart>& charts,
+		std::vector<std::vector<short>>& actions)
+	{
+		if (accounts.size() != ranges.size())
+		{
+			ERROR("Backtest: %u accounts were given for %u permutations",
+				accounts.size(), ranges.size());
+			return false;
+		}
+
+		if (candles.size() < window)
+		{
+			ERROR("Backtest: %u candles were given but at least %u are required",
+				candles.size(), window);
+			return false;
+		}
+
+		try
+		{
+			strat->execute_batch(charts, actions, candles, ranges, window);
+		}
+		catch (const std::string& err)
+		{
+			ERROR("Backtest: Strategy: %s", err);
+			return false;
+		}
+
+		const double *close = candles.closes();
+
+		for (unsigned i = window - 1; i < candles.size(); i++)
+		{
+			for (size_t a = 0; a < accounts.size(); ++a)
+			{
+				SimAccount& acc = accounts[a];
+				if (acc.failed()) continue;
+
+				acc.update_price(close[i]);
+
+				bool success;
+				switch (actions[a][i])
+				{
+				case NOTHING:
+					success = true;
+					break;
+				case ENTER_LONG:
+					success = acc.enter_long();
+					break;
+				case EXIT_LONG:
+					success = acc.exit_long();
+					break;
+				case ENTER_SHORT:
+					success = acc.enter_short();
+					break;
+				case EXIT_SHORT:
+					success = acc.exit_short();
+					break;
+				default:
+					success = false;
+					break;
+				}
+
+				if (!success) acc.fail();
+			}
+		}
+
+		for (SimAccount& acc : accounts)
+		{
+			if (!acc.failed() && !acc.close_position()) acc.fail();
+		}
+
+		return true;
+	}
+
+	// how far a series is through the merge and what its strategy keeps
+	struct SeriesCursor
+	{
+		unsigned next = 0;
+		std::shared_ptr<void> state;
+		CandleWindow window;
+		Chart chart;
+	};
+
+	// timestamp of the next candle of a series and the index of the series
+	typedef std::pair<long long, unsigned> MergeEntry;
+
+	// orders the heap so that the earliest candle is on top
+	static bool later(const MergeEntry& a, const MergeEntry& b)
+	{
+		return a > b;
+	}
+
+	/**
+	 * Gets the action of a strategy at a candle of a series. Incremental
+	 * strategies are started with the first window of candles and then
+	 * fed one candle at a time. Others are executed over a window of the
+	 * newest candles that was pushed to as the series was merged, so
+	 * either way a series never holds more than a window of candles.
+	 */
+	static short next_action(const PortfolioSeries& series, SeriesCursor& cursor,
+		unsigned index)
+	{
+		const PriceHistory& candles = *series.candles;
+
+		if (cursor.state)
+		{
+			if (index + 1 < series.window) return NOTHING;
+
+			if (index + 1 == series.window)
+				return series.strat->init(cursor.state.get(), candles.slice(0, series.window));
+
+			return series.strat->on_candle(cursor.state.get(), candles[index],
+				candles.timestamp(index));
+		}
+
+		cursor.window.push(candles[index], candles.timestamp(index));
+
+		if (index + 1 < series.window) return NOTHING;
+
+		series.strat->execute(cursor.chart, cursor.window.view(), series.ranges);
+
+		return cursor.chart.action();
+	}
+
+	/**
+	 * Backtests every asset of a portfolio on one time axis with an
+	 * account they share, so that orders are sized from the account as it
+	 * is after the other assets traded, the same as live. The series are
+	 * merged by a min-heap of the timestamp of their next candle, which
+	 * only ever holds one entry per series. Candles are read from each
+	 * series in order as the merge reaches them, so memory mapped
+	 * histories are streamed from disk instead of loaded up front.
+	 *
+	 * Candles of different assets with the same timestamp are traded in
+	 * the order of the series, and the drawdown of the account is
+	 * recorded once every asset has been updated to a timestamp.
+	 *
+	 * @param	acc		account with an asset added for every series, in order
+	 * @param	series	candles and strategy of every asset
+	 * @return			false if a strategy or an order failed
+	 */
+	bool backtest_portfolio(PortfolioAccount& acc,
+		const std::vector<PortfolioSeries>& series)
+	{
+		if (acc.size() != series.size())
+		{
+			ERROR("Backtest: %u series were given for an account of %u assets",
+				series.size(), acc.size());
+			return false;
+		}
+
+		std::vector<SeriesCursor> cursors(series.size());
+		std::vector<MergeEntry> heap;
+		heap.reserve(series.size());
+
+		try
+		{
+			for (unsigned s = 0; s < series.size(); ++s)
+			{
+				const PortfolioSeries& curr = series[s];
+
+				if (curr.window == 0 || curr.candles->size() < curr.window)
+				{
+					ERROR("Backtest: %u candles were given but at least %u are required",
+						curr.candles->size(), curr.window);
+					return false;
+				}
+
+				if (curr.strat->is_incremental())
+					cursors[s].state = curr.strat->create_state(curr.ranges);
+
+				if (!cursors[s].state)
+					cursors[s].window = CandleWindow(curr.window, curr.candles->interval());
+
+				heap.push_back({ curr.candles->timestamp(0), s });
+			}
+
+			std::make_heap(heap.begin(), heap.end(), later);
+
+			long long now = heap.empty() ? 0 : heap.front().first;
+
+			while (!heap.empty())
+			{
+				std::pop_heap(heap.begin(), heap.end(), later);
+				MergeEntry entry = heap.back();
+				heap.pop_back();
+
+				if (entry.first != now)
+				{
+					acc.record_equity();
+					now = entry.first;
+				}
+
+				unsigned s = entry.second;
+				const PriceHistory& candles = *series[s].candles;
+				SeriesCursor& cursor = cursors[s];
+				unsigned i = cursor.next++;
+
+				acc.update_price(s, candles.closes()[i]);
+
+				bool success = true;
+				switch (next_action(series[s], cursor, i))
+				{
+				case NOTHING:
+					break;
+				case ENTER_LONG:
+					success = acc.enter_long(s);
+					break;
+				case EXIT_LONG:
+					success = acc.exit_long(s);
+					break;
+				case ENTER_SHORT:
+					success = acc.enter_short(s);
+					break;
+				case EXIT_SHORT:
+					success = acc.exit_short(s);
+					break;
+				case ERROR:
+					return false;
+				default:
+					ERROR("Invalid action received from strategy");
+					return false;
+				}
+
+				if (!success)
+				{
+					ERROR("Backtest: order failed at candle %u of series %u", i, s);
+					return false;
+				}
+
+				if (cursor.next < candles.size())
+				{
+					heap.push_back({ candles.timestamp(cursor.next), s });
+					std::push_heap(heap.begin(), heap.end(), later);
+				}
+			}
+		}
+		catch (const std::string& err)
+		{
+			ERROR("Backtest: Strategy: %s", err);
+			return false;
+		}
+
+		acc.record_equity();
+
+		if (!acc.close_all_positions()) return false;
+
+		acc.record_equity();
+
+		return true;
+	}
+
+	/**
+	 * Finds the accounts with the highest return. Failed accounts are left
+	 * out.
+	 *
+	 * @param	accounts	accounts of a sweep
+	 * @param	count		amount of accounts to find
+	 * @return				indices of the best accounts, best first
+	 */
+	std::vector<unsigned> best_accounts(const std::vector<SimAccount>& accounts,
+		unsigned count)
+	{
+		std::vector<unsigned> indices;
+		indices.reserve(accounts.size());
+
+		for (unsigned i = 0; i < accounts.size(); ++i)
+		{
+			if (!accounts[i].failed()) indices.push_back(i);
+		}
+
+		if (count > indices.size()) count = indices.size();
+
+		std::partial_sort(indices.begin(), indices.begin() + count, indices.end(),
+			[&](unsigned a, unsigned b)
+			{
+				return accounts[a].pct_return() > accounts[b].pct_return();
+			});
+
+		indices.resize(count);
+
+		return indices;
+	}
+
 	// bool backtest_interval(PaperAccount* best, const Asset* asset, const Strategy* strat,
 	// 	int interval, long long permutations, double principal, double minimum, double fee, bool shorting_enabled,
 	// 	int leverage, int min_range, int max_range, int granularity, const std::vector<int>& start_ranges)
@@ -234,23 +640,4 @@ namespace daytrender
 
 	// 	return { acc0, acc1 };
 	// }
-
-	// current interval, current ranges
-	Result<PaperAccount> backtest_asset(const Client *client,
-		const Asset& asset, const Strategy *strategy)
-	{
-		PaperAccount out;
-
-		Result<PriceHistory> res = client->get_price_history(asset.ticker(),
-			asset.interval(), 0);
-
-		if (!res)
-		{
-			ERROR(res.error());
-			return NULL;
-		}
-
-		// if (!backtest_permutation(out, 
-		return out;
-	}
 }
\ No newline at end of file
@@ -0,0 +1,836 @@
+#include <util/indicators.h>
+
+// local includes
+#include <util/arena.h>
+#include <util/vectorops.h>
+
+// standard library
+#include <cmath>
+
+// ranges that batch kernels update side by side
+#define BATCH_LANES 8
+
+namespace daytrender
+{
+	namespace indicators
+	{
+		typedef void (*ElementOp)(const double*, const double*, double*, unsigned);
+
+		/**
+		 * Gets the index of the candle that the first value of the indicator
+		 * lines up with. Indicators that are empty or longer than the
+		 * candles are left untouched.
+		 */
+		static bool get_offset(const Indicator& data, const PriceHistory& candles,
+			unsigned& offset)
+		{
+			if (data.size() == 0 || data.size() > candles.size()) return false;
+			offset = candles.size() - data.size();
+			return true;
+		}
+
+		// first candle of the window that ends on the given one
+		static inline unsigned window_start(unsigned index, unsigned range)
+		{
+			return (index + 1 > range) ? index + 1 - range : 0;
+		}
+
+		/**
+		 * Exponential smoothing of x from offset to the end of it. The
+		 * first value is the mean of the window ending at offset.
+		 */
+		static double window_mean(const double* x, unsigned offset, unsigned range)
+		{
+			unsigned first = window_start(offset, range);
+
+			double sum = 0.0;
+			for (unsigned i = first; i <= offset; ++i)
+			{
+				sum += x[i];
+			}
+
+			return sum / (double)(offset + 1 - first);
+		}
+
+		static void smooth(const double* x, unsigned size, unsigned offset,
+			unsigned range, double alpha, double* out)
+		{
+			out[0] = window_mean(x, offset, range);
+
+			for (unsigned i = 1; i < size - offset; ++i)
+			{
+				out[i] = x[offset + i] * alpha + out[i - 1] * (1.0 - alpha);
+			}
+		}
+
+		/**
+		 * Mean of x over the window ending on every index from offset to the
+		 * end of it. Window sums are differences of a running sum, so the
+		 * full windows are a single vectorized pass.
+		 */
+		static void rolling_mean(const double* x, unsigned size, unsigned offset,
+			unsigned range, double* out)
+		{
+			unsigned base = window_start(offset, range);
+			unsigned count = size - offset;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			double* sum = arena.allocate<double>(size - base + 1);
+			sum[0] = 0.0;
+			for (unsigned i = base; i < size; ++i)
+			{
+				sum[i - base + 1] = sum[i - base] + x[i];
+			}
+
+			// windows cut short by the start of the history (base is 0 here)
+			unsigned j = 0;
+			for (; j < count && offset + j + 1 < range; ++j)
+			{
+				out[j] = sum[offset + j + 1] / (double)(offset + j + 1);
+			}
+
+			if (j == count) return;
+
+			unsigned end = offset + j + 1 - base;
+			vectorops::scaled_diff(sum + end, sum + end - range,
+				1.0 / (double)range, 0.0, out + j, count - j);
+		}
+
+		/**
+		 * Lowest or highest value of x over the window ending on every index
+		 * from offset to the end of it. Full windows use the van Herk/Gil-Werman
+		 * method: the values are split into blocks of range, and each window
+		 * is the extreme of a block suffix and the next block's prefix.
+		 */
+		static void rolling_extreme(const double* x, unsigned size, unsigned offset,
+			unsigned range, bool highest, double* out)
+		{
+			ElementOp op = highest ? vectorops::max : vectorops::min;
+			auto beats = [highest](double a, double b)
+			{
+				return highest ? a > b : a < b;
+			};
+
+			unsigned count = size - offset;
+			unsigned j = 0;
+
+			// windows cut short by the start of the history
+			if (offset + 1 < range)
+			{
+				double extreme = x[0];
+				for (unsigned i = 1; i <= offset; ++i)
+				{
+					if (beats(x[i], extreme)) extreme = x[i];
+				}
+
+				for (; j < count && offset + j + 1 < range; ++j)
+				{
+					if (beats(x[offset + j], extreme)) extreme = x[offset + j];
+					out[j] = extreme;
+				}
+			}
+
+			if (j == count) return;
+
+			const double* y = x + (offset + j + 1 - range);
+			unsigned len = size - (offset + j + 1 - range);
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			double* prefix = arena.allocate<double>(len);
+			double* suffix = arena.allocate<double>(len);
+
+			for (unsigned i = 0; i < len; ++i)
+			{
+				prefix[i] = (i % range == 0 || beats(y[i], prefix[i - 1]))
+					? y[i]
+					: prefix[i - 1];
+			}
+
+			for (unsigned i = len; i-- > 0;)
+			{
+				suffix[i] = (i + 1 == len || (i + 1) % range == 0 || beats(y[i], suffix[i + 1]))
+					? y[i]
+					: suffix[i + 1];
+			}
+
+			op(suffix, prefix + range - 1, out + j, count - j);
+		}
+
+		// range of the slow average of macd
+		static unsigned get_slow_range(unsigned range)
+		{
+			unsigned slow_range = range * 26 / 12;
+			return (slow_range <= range) ? range + 1 : slow_range;
+		}
+
+		// scratch array of n zeros
+		static double* zeros(Arena& arena, unsigned n)
+		{
+			double* out = arena.allocate<double>(n);
+			for (unsigned i = 0; i < n; ++i) out[i] = 0.0;
+			return out;
+		}
+
+		// replaces values of an oscillator that had no movement with its midpoint
+		static void fill_flat(const double* lo, const double* hi, double* out,
+			unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i)
+			{
+				if (hi[i] == lo[i]) out[i] = 50.0;
+			}
+		}
+
+		void sma(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			rolling_mean(candles.closes(), candles.size(), offset, range, &data[0]);
+		}
+
+		void ema(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			smooth(candles.closes(), candles.size(), offset, range,
+				2.0 / (double)(range + 1), &data[0]);
+		}
+
+		void wma(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			const double* close = candles.closes();
+			double* out = &data[0];
+
+			// weights go from 1 on the oldest candle to width on the newest
+			unsigned first = window_start(offset, range);
+			unsigned width = offset + 1 - first;
+			double numerator = 0.0;
+			double total = 0.0;
+
+			for (unsigned i = first; i <= offset; ++i)
+			{
+				numerator += (double)(i - first + 1) * close[i];
+				total += close[i];
+			}
+
+			out[0] = numerator / (width * (width + 1) / 2.0);
+
+			for (unsigned i = 1; i < data.size(); ++i)
+			{
+				unsigned c = offset + i;
+
+				if (width < range)
+				{
+					// window is still growing so old weights stay the same
+					width++;
+					numerator += (double)width * close[c];
+					total += close[c];
+				}
+				else
+				{
+					// every old weight drops by one
+					numerator += (double)range * close[c] - total;
+					total += close[c] - close[c - range];
+				}
+
+				out[i] = numerator / (width * (width + 1) / 2.0);
+			}
+		}
+
+		void rsi(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			double* out = &data[0];
+			unsigned count = data.size();
+
+			// the first candle has no change
+			if (offset == 0)
+			{
+				out[0] = 50.0;
+				out++;
+				count--;
+				offset++;
+			}
+
+			if (count == 0) return;
+
+			const double* close = candles.closes();
+			unsigned changes = candles.size() - 1;
+
+			// change[i] is the movement into candle i + 1
+			double* change = arena.allocate<double>(changes);
+			double* zero = zeros(arena, changes);
+			double* gain = arena.allocate<double>(changes);
+			double* loss = arena.allocate<double>(changes);
+
+			vectorops::scaled_diff(close + 1, close, 1.0, 0.0, change, changes);
+			vectorops::max(change, zero, gain, changes);
+			vectorops::min(change, zero, loss, changes);
+			vectorops::scaled_diff(zero, loss, 1.0, 0.0, loss, changes);
+
+			double* avg_gain = arena.allocate<double>(count);
+			double* avg_loss = arena.allocate<double>(count);
+			double alpha = 1.0 / (double)range;
+
+			smooth(gain, changes, offset - 1, range, alpha, avg_gain);
+			smooth(loss, changes, offset - 1, range, alpha, avg_loss);
+
+			// rsi = 100 * gain / (gain + loss)
+			double* movement = arena.allocate<double>(count);
+			vectorops::add_scaled(avg_gain, avg_loss, 1.0, movement, count);
+			vectorops::normalize(avg_gain, zero, movement, 100.0, out, count);
+			fill_flat(zero, movement, out, count);
+		}
+
+		void macd(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			unsigned slow_range = get_slow_range(range);
+
+			double* fast = arena.allocate<double>(data.size());
+			double* slow = arena.allocate<double>(data.size());
+
+			smooth(candles.closes(), candles.size(), offset, range,
+				2.0 / (double)(range + 1), fast);
+			smooth(candles.closes(), candles.size(), offset, slow_range,
+				2.0 / (double)(slow_range + 1), slow);
+
+			vectorops::scaled_diff(fast, slow, 1.0, 0.0, &data[0], data.size());
+		}
+
+		static void bollinger(Indicator& data, const PriceHistory& candles,
+			unsigned range, double deviations)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			const double* close = candles.closes();
+			unsigned base = window_start(offset, range);
+
+			// deviations are taken from the first close so the squares stay small
+			// and the variance does not cancel out
+			double* shifted = arena.allocate<double>(candles.size());
+			double* square = arena.allocate<double>(candles.size());
+			for (unsigned i = base; i < candles.size(); ++i)
+			{
+				shifted[i] = close[i] - close[base];
+				square[i] = shifted[i] * shifted[i];
+			}
+
+			double* mean = arena.allocate<double>(data.size());
+			double* shifted_mean = arena.allocate<double>(data.size());
+			double* deviation = arena.allocate<double>(data.size());
+
+			rolling_mean(close, candles.size(), offset, range, mean);
+			rolling_mean(shifted, candles.size(), offset, range, shifted_mean);
+			rolling_mean(square, candles.size(), offset, range, deviation);
+			vectorops::stddev(shifted_mean, deviation, deviation, data.size());
+			vectorops::add_scaled(mean, deviation, deviations, &data[0], data.size());
+		}
+
+		void bollinger_upper(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			bollinger(data, candles, range, 2.0);
+		}
+
+		void bollinger_lower(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			bollinger(data, candles, range, -2.0);
+		}
+
+		void atr(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			const double* high = candles.highs();
+			const double* low = candles.lows();
+			unsigned size = candles.size();
+
+			// the close before each candle is the close column shifted by one
+			double* tr = arena.allocate<double>(size);
+			tr[0] = high[0] - low[0];
+			vectorops::true_range(high + 1, low + 1, candles.closes(), tr + 1, size - 1);
+
+			smooth(tr, size, offset, range, 1.0 / (double)range, &data[0]);
+		}
+
+		void stochastic(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			Arena& arena = Arena::local();
+			Arena::Scope scope(arena);
+
+			double* lowest = arena.allocate<double>(data.size());
+			double* highest = arena.allocate<double>(data.size());
+
+			rolling_extreme(candles.lows(), candles.size(), offset, range, false, lowest);
+			rolling_extreme(candles.highs(), candles.size(), offset, range, true, highest);
+			vectorops::normalize(candles.closes() + offset, lowest, highest,
+				100.0, &data[0], data.size());
+			fill_flat(lowest, highest, &data[0], data.size());
+		}
+
+		void rolling_min(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			rolling_extreme(candles.closes(), candles.size(), offset, range, false, &data[0]);
+		}
+
+		void rolling_max(Indicator& data, const PriceHistory& candles, unsigned range)
+		{
+			unsigned offset;
+			if (!get_offset(data, candles, offset)) return;
+			if (range == 0) range = 1;
+
+			rolling_extreme(candles.closes(), candles.size(), offset, range, true, &data[0]);
+		}
+	
+		namespace stream
+		{
+			// moves the front of the ring past candles that left the window
+			static void expire(Extremes& q, unsigned long long count, unsigned range)
+			{
+				while (q.size > 0 && q.index[q.head] + range <= count)
+				{
+					q.head = (q.head + 1) % q.index.size();
+					q.size--;
+				}
+			}
+
+			/**
+			 * Extreme of the window that ends on x, which would be candle
+			 * number count. The ring is only changed when committing.
+			 */
+			static double extreme(Extremes& q, unsigned long long count,
+				unsigned range, double x, bool highest, bool commit)
+			{
+				auto beats = [highest](double a, double b)
+				{
+					return highest ? a >= b : a <= b;
+				};
+
+				unsigned cap = q.index.size();
+
+				if (!commit)
+				{
+					// at most the oldest candle leaves the window
+					unsigned i = q.head;
+					unsigned size = q.size;
+
+					if (size > 0 && q.index[i] + range <= count)
+					{
+						i = (i + 1) % cap;
+						size--;
+					}
+
+					return (size == 0 || beats(x, q.value[i])) ? x : q.value[i];
+				}
+
+				// candles that x beats can never be the extreme again
+				while (q.size > 0 && beats(x, q.value[(q.head + q.size - 1) % cap]))
+				{
+					q.size--;
+				}
+
+				expire(q, count, range);
+
+				unsigned back = (q.head + q.size) % cap;
+				q.index[back] = count;
+				q.value[back] = x;
+				q.size++;
+
+				return q.value[q.head];
+			}
+
+			// moves the stream on to the next candle
+			static void advance(Stream& s, double input)
+			{
+				s.window[s.count % s.range] = input;
+				s.count++;
+			}
+
+			// input that leaves the window when the next candle enters it
+			static inline double leaving(const Stream& s)
+			{
+				return (s.count >= s.range) ? s.window[s.count % s.range] : 0.0;
+			}
+
+			// amount of candles in the window that ends on the next candle
+			static inline unsigned width(const Stream& s)
+			{
+				return (s.count + 1 < s.range) ? s.count + 1 : s.range;
+			}
+
+			static double smooth(double prev, double x, double alpha, bool first)
+			{
+				return first ? x : x * alpha + prev * (1.0 - alpha);
+			}
+
+			void reset(Stream& s, unsigned range)
+			{
+				if (range == 0) range = 1;
+
+				s.range = range;
+				s.count = 0;
+				s.value = 0.0;
+				s.other = 0.0;
+				s.square = 0.0;
+				s.prev = 0.0;
+				s.origin = 0.0;
+				s.window.assign(range, 0.0);
+
+				for (Extremes* q : { &s.lowest, &s.highest })
+				{
+					q->index.assign(range + 1, 0);
+					q->value.assign(range + 1, 0.0);
+					q->head = 0;
+					q->size = 0;
+				}
+			}
+
+			double sma(Stream& s, const Candle& candle, bool commit)
+			{
+				double x = candle.close();
+				double sum = s.value + x - leaving(s);
+				double out = sum / (double)width(s);
+
+				if (commit)
+				{
+					s.value = sum;
+					advance(s, x);
+				}
+
+				return out;
+			}
+
+			double ema(Stream& s, const Candle& candle, bool commit)
+			{
+				double out = smooth(s.value, candle.close(),
+					2.0 / (double)(s.range + 1), s.count == 0);
+
+				if (commit)
+				{
+					s.value = out;
+					s.count++;
+				}
+
+				return out;
+			}
+
+			double wma(Stream& s, const Candle& candle, bool commit)
+			{
+				double x = candle.close();
+				double numerator;
+				double total;
+
+				if (s.count < s.range)
+				{
+					// window is still growing so old weights stay the same
+					numerator = s.value + (double)(s.count + 1) * x;
+					total = s.other + x;
+				}
+				else
+				{
+					// every old weight drops by one
+					numerator = s.value + (double)s.range * x - s.other;
+					total = s.other + x - leaving(s);
+				}
+
+				double w = width(s);
+				double out = numerator / (w * (w + 1) / 2.0);
+
+				if (commit)
+				{
+					s.value = numerator;
+					s.other = total;
+					advance(s, x);
+				}
+
+				return out;
+			}
+
+			double rsi(Stream& s, const Candle& candle, bool commit)
+			{
+				double x = candle.close();
+
+				// the first candle has no change
+				if (s.count == 0)
+				{
+					if (commit)
+					{
+						s.prev = x;
+						s.count++;
+					}
+
+					return 50.0;
+				}
+
+				double change = x - s.prev;
+				double gain = (change > 0.0) ? change : 0.0;
+				double loss = (change < 0.0) ? -change : 0.0;
+				double alpha = 1.0 / (double)s.range;
+				bool first = s.count == 1;
+
+				double avg_gain = smooth(s.value, gain, alpha, first);
+				double avg_loss = smooth(s.other, loss, alpha, first);
+				double movement = avg_gain + avg_loss;
+
+				if (commit)
+				{
+					s.value = avg_gain;
+					s.other = avg_loss;
+					s.prev = x;
+					s.count++;
+				}
+
+				return (movement == 0.0) ? 50.0 : avg_gain / movement * 100.0;
+			}
+
+			double macd(Stream& s, const Candle& candle, bool commit)
+			{
+				unsigned slow_range = get_slow_range(s.range);
+				double x = candle.close();
+
+				double fast = smooth(s.value, x, 2.0 / (double)(s.range + 1), s.count == 0);
+				double slow = smooth(s.other, x, 2.0 / (double)(slow_range + 1), s.count == 0);
+
+				if (commit)
+				{
+					s.value = fast;
+					s.other = slow;
+					s.count++;
+				}
+
+				return fast - slow;
+			}
+
+			/**
+			 * Deviations are taken from the first close, like the kernel
+			 * does, so the squares stay small.
+			 */
+			static double bollinger(Stream& s, const Candle& candle, bool commit,
+				double deviations)
+			{
+				double x = candle.close();
+				double origin = (s.count == 0) ? x : s.origin;
+				double shifted = x - origin;
+				double old = leaving(s);
+
+				double sum = s.value + shifted - old;
+				double square = s.square + shifted * shifted - old * old;
+				double w = width(s);
+
+				double mean = sum / w;
+				double variance = square / w - mean * mean;
+				double deviation = (variance > 0.0) ? std::sqrt(variance) : 0.0;
+
+				if (commit)
+				{
+					s.origin = origin;
+					s.value = sum;
+					s.square = square;
+					advance(s, shifted);
+
+					// recounting the sums once per window keeps rounding errors
+					// from building up and is still constant time on average
+					if (s.count % s.range == 0)
+					{
+						s.value = 0.0;
+						s.square = 0.0;
+						for (double d : s.window)
+						{
+							s.value += d;
+							s.square += d * d;
+						}
+					}
+				}
+
+				return origin + mean + deviation * deviations;
+			}
+
+			double bollinger_upper(Stream& s, const Candle& candle, bool commit)
+			{
+				return bollinger(s, candle, commit, 2.0);
+			}
+
+			double bollinger_lower(Stream& s, const Candle& candle, bool commit)
+			{
+				return bollinger(s, candle, commit, -2.0);
+			}
+
+			double atr(Stream& s, const Candle& candle, bool commit)
+			{
+				double tr = candle.high() - candle.low();
+
+				if (s.count > 0)
+				{
+					double up = std::abs(candle.high() - s.prev);
+					double down = std::abs(candle.low() - s.prev);
+
+					if (up > tr) tr = up;
+					if (down > tr) tr = down;
+				}
+
+				double out = smooth(s.value, tr, 1.0 / (double)s.range, s.count == 0);
+
+				if (commit)
+				{
+					s.value = out;
+					s.prev = candle.close();
+					s.count++;
+				}
+
+				return out;
+			}
+
+			double stochastic(Stream& s, const Candle& candle, bool commit)
+			{
+				double lo = extreme(s.lowest, s.count, s.range, candle.low(), false, commit);
+				double hi = extreme(s.highest, s.count, s.range, candle.high(), true, commit);
+
+				if (commit) s.count++;
+
+				return (hi == lo) ? 50.0 : (candle.close() - lo) / (hi - lo) * 100.0;
+			}
+
+			double rolling_min(Stream& s, const Candle& candle, bool commit)
+			{
+				double out = extreme(s.lowest, s.count, s.range, candle.close(), false, commit);
+				if (commit) s.count++;
+				return out;
+			}
+
+			double rolling_max(Stream& s, const Candle& candle, bool commit)
+			{
+				double out = extreme(s.highest, s.count, s.range, candle.close(), true, commit);
+				if (commit) s.count++;
+				return out;
+			}
+		}
+
+		namespace batch
+		{
+			/**
+			 * Exponential smoothing of x for a fixed amount of lanes that
+			 * start from their first values. The lanes do not depend on each
+			 * other, so the compiler can update them together.
+			 */
+			template <unsigned Lanes>
+			static void smooth_lanes(const double* x, unsigned size, unsigned offset,
+				const double* alpha, double* const* out)
+			{
+				double value[Lanes];
+				double keep[Lanes];
+
+				for (unsigned l = 0; l < Lanes; ++l)
+				{
+					value[l] = out[l][0];
+					keep[l] = 1.0 - alpha[l];
+				}
+
+				for (unsigned i = 1; i < size - offset; ++i)
+				{
+					double xi = x[offset + i];
+
+					for (unsigned l = 0; l < Lanes; ++l)
+					{
+						value[l] = xi * alpha[l] + value[l] * keep[l];
+						out[l][i] = value[l];
+					}
+				}
+			}
+
+			void ema(Indicator** data, const PriceHistory& candles,
+				const unsigned* ranges, unsigned count)
+			{
+				const double* close = candles.closes();
+				unsigned done = 0;
+
+				while (done < count)
+				{
+					unsigned offset;
+					if (!get_offset(*data[done], candles, offset))
+					{
+						done++;
+						continue;
+					}
+
+					// indicators of the same size line up with the same candles
+					unsigned lanes = 1;
+					while (lanes < BATCH_LANES && done + lanes < count
+						&& data[done + lanes]->size() == data[done]->size()) lanes++;
+
+					if (lanes < 4)
+					{
+						indicators::ema(*data[done], candles, ranges[done]);
+						done++;
+						continue;
+					}
+
+					lanes = (lanes == BATCH_LANES) ? BATCH_LANES : 4;
+
+					double alpha[BATCH_LANES];
+					double* out[BATCH_LANES];
+
+					for (unsigned l = 0; l < lanes; ++l)
+					{
+						unsigned range = ranges[done + l] ? ranges[done + l] : 1;
+						alpha[l] = 2.0 / (double)(range + 1);
+						out[l] = &(*data[done + l])[0];
+						out[l][0] = window_mean(close, offset, range);
+					}
+
+					if (lanes == BATCH_LANES)
+					{
+						smooth_lanes<BATCH_LANES>(close, candles.size(), offset, alpha, out);
+					}
+					else
+					{
+						smooth_lanes<4>(close, candles.size(), offset, alpha, out);
+					}
+
+					done += lanes;
+				}
+			}
+		}
+	}
+}
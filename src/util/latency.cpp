@@ -0,0 +1,229 @@
+#include <util/latency.h>
+
+// standard library
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// values under this are exact and every power of two above is split in this many
+#define SUB_BUCKETS 16
+#define SUB_BITS 4
+#define BUCKET_COUNT (SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS)
+
+namespace daytrender
+{
+	namespace latency
+	{
+		struct Histogram
+		{
+			std::atomic<unsigned long long> buckets[BUCKET_COUNT] = {};
+			std::atomic<unsigned long long> count = 0;
+			std::atomic<unsigned long long> sum = 0;
+			std::atomic<unsigned long long> max = 0;
+		};
+
+		// histograms of one thread, only ever written by it
+		struct Histograms
+		{
+			Histogram stages[STAGE_COUNT];
+		};
+
+		/**
+		 * Histograms of every thread that has recorded. Those of threads
+		 * that have exited keep their values and are handed to the next
+		 * new thread, so threads that come and go do not add up.
+		 */
+		struct Registry
+		{
+			std::mutex mtx;
+			std::vector<std::unique_ptr<Histograms>> all;
+			std::vector<Histograms*> free;
+		};
+
+		static Registry& registry()
+		{
+			// never destroyed since threads can record while the program exits
+			static Registry *registry = new Registry();
+			return *registry;
+		}
+
+		struct Slot
+		{
+			Histograms *histograms = nullptr;
+
+			~Slot()
+			{
+				if (!histograms) return;
+
+				Registry& reg = registry();
+				std::lock_guard<std::mutex> lock(reg.mtx);
+				reg.free.push_back(histograms);
+			}
+		};
+
+		static Histograms& local()
+		{
+			static thread_local Slot slot;
+
+			if (slot.histograms) return *slot.histograms;
+
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mtx);
+
+			if (reg.free.empty())
+			{
+				reg.all.push_back(std::make_unique<Histograms>());
+				slot.histograms = reg.all.back().get();
+			}
+			else
+			{
+				slot.histograms = reg.free.back();
+				reg.free.pop_back();
+			}
+
+			return *slot.histograms;
+		}
+
+		static inline unsigned bucket_of(unsigned long long value)
+		{
+			if (value < SUB_BUCKETS) return value;
+
+			unsigned exponent = 63 - __builtin_clzll(value);
+			unsigned shift = exponent - SUB_BITS;
+
+			return SUB_BUCKETS + shift * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+		}
+
+		// middle of the values that go in a bucket
+		static inline unsigned long long bucket_value(unsigned bucket)
+		{
+			if (bucket < SUB_BUCKETS) return bucket;
+
+			unsigned shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+			unsigned long long sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+			unsigned long long low = (SUB_BUCKETS + sub) << shift;
+
+			return low + ((1ULL << shift) >> 1);
+		}
+
+		// only the owning thread writes, so a load and store are enough
+		static inline void add(std::atomic<unsigned long long>& value,
+			unsigned long long amount)
+		{
+			value.store(value.load(std::memory_order_relaxed) + amount,
+				std::memory_order_relaxed);
+		}
+
+		void record(Stage stage, unsigned long long nanoseconds)
+		{
+			Histogram& hist = local().stages[stage];
+
+			add(hist.buckets[bucket_of(nanoseconds)], 1);
+			add(hist.count, 1);
+			add(hist.sum, nanoseconds);
+
+			if (nanoseconds > hist.max.load(std::memory_order_relaxed))
+				hist.max.store(nanoseconds, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Adds up the histograms of every thread for a stage. Records that
+		 * happen at the same time may or may not be counted.
+		 */
+		Summary summary(Stage stage)
+		{
+			std::vector<unsigned long long> buckets(BUCKET_COUNT, 0);
+			Summary out = { 0, 0, 0, 0, 0 };
+			unsigned long long sum = 0;
+
+			{
+				Registry& reg = registry();
+				std::lock_guard<std::mutex> lock(reg.mtx);
+
+				for (const auto& histograms : reg.all)
+				{
+					const Histogram& hist = histograms->stages[stage];
+
+					for (unsigned i = 0; i < BUCKET_COUNT; ++i)
+					{
+						buckets[i] += hist.buckets[i].load(std::memory_order_relaxed);
+					}
+
+					out.count += hist.count.load(std::memory_order_relaxed);
+					sum += hist.sum.load(std::memory_order_relaxed);
+
+					unsigned long long max = hist.max.load(std::memory_order_relaxed);
+					if (max > out.max) out.max = max;
+				}
+			}
+
+			if (out.count == 0) return out;
+
+			out.mean = sum / out.count;
+
+			// the count can be ahead of the buckets, so they are counted again
+			unsigned long long total = 0;
+			for (unsigned long long count : buckets) total += count;
+
+			unsigned long long p50_rank = (total + 1) / 2;
+			unsigned long long p99_rank = total - total / 100;
+			unsigned long long seen = 0;
+
+			for (unsigned i = 0; i < BUCKET_COUNT; ++i)
+			{
+				if (buckets[i] == 0) continue;
+
+				seen += buckets[i];
+
+				if (out.p50 == 0 && seen >= p50_rank) out.p50 = bucket_value(i);
+				if (seen >= p99_rank)
+				{
+					out.p99 = bucket_value(i);
+					break;
+				}
+			}
+
+			if (out.p50 > out.max) out.p50 = out.max;
+			if (out.p99 > out.max) out.p99 = out.max;
+
+			return out;
+		}
+
+		const char *name(Stage stage)
+		{
+			switch (stage)
+			{
+			case FETCH:				return "fetch";
+			case EXECUTE:			return "execute";
+			case ORDER:				return "order";
+			case PORTFOLIO_UPDATE:	return "portfolio_update";
+			default:				return "unknown";
+			}
+		}
+
+		/**
+		 * Summary of every stage in milliseconds, one per line
+		 */
+		std::string report()
+		{
+			std::string out;
+			char line[192];
+
+			for (unsigned i = 0; i < STAGE_COUNT; ++i)
+			{
+				Stage stage = (Stage)i;
+				Summary sum = summary(stage);
+
+				std::snprintf(line, sizeof(line),
+					"%-16s count: %-8llu mean: %10.3fms  p50: %10.3fms  p99: %10.3fms  max: %10.3fms\n",
+					name(stage), sum.count, sum.mean / 1e6, sum.p50 / 1e6, sum.p99 / 1e6,
+					sum.max / 1e6);
+				out += line;
+			}
+
+			return out;
+		}
+	}
+}
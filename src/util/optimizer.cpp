@@ -0,0 +1,457 @@
+#include <interface/optimizer.h>
+
+// local includes
+#include <interface/backtest.h>
+#include <util/arena.h>
+
+// standard library
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// external libraries
+#include <hirzel/logger.h>
+
+// permutations that batchable strategies backtest in one pass
+#define BATCH_SIZE 8
+
+namespace daytrender
+{
+	double get_metric(const PaperAccount& acc, Metric metric)
+	{
+		double value = 0.0;
+
+		switch (metric)
+		{
+		case NET_RETURN:
+			value = acc.net_return();
+			break;
+		case PCT_RETURN:
+			value = acc.pct_return();
+			break;
+		case PCT_PER_YEAR:
+			value = acc.pct_per_year();
+			break;
+		case SHARPE_RATIO:
+			value = acc.sharpe_ratio();
+			break;
+		case KELLY_CRITERION:
+			value = acc.kelly_criterion();
+			break;
+		case WIN_RATE:
+			value = acc.win_rate();
+			break;
+		case PROFIT_RATE:
+			value = acc.profit_rate();
+			break;
+		}
+
+		// undefined metrics (no trades, no volatility) rank last
+		if (std::isnan(value)) return -std::numeric_limits<double>::infinity();
+
+		return value;
+	}
+
+	/**
+	 * Kelly criterion of the out of sample trades, which is how much of
+	 * the account should be risked on the strategy. It is 0 when they did
+	 * not show an edge.
+	 */
+	double WalkForward::risk() const
+	{
+		double kelly = account.kelly_criterion();
+
+		if (std::isnan(kelly) || kelly <= 0.0) return 0.0;
+		if (kelly > 1.0) return 1.0;
+
+		return kelly;
+	}
+
+	/**
+	 * Permutations of ranges that a sweep backtests and how they are split
+	 * into tasks for the pool. Permutation p has a range for each of its
+	 * digits in base possible_vals, so any task can decode its own.
+	 */
+	struct RangeSweep
+	{
+		unsigned min_range;
+		unsigned granularity;
+		unsigned range_count;
+		unsigned long long possible_vals;
+		unsigned long long permutations = 1;
+		unsigned long long chunk;
+		unsigned long long task_count;
+
+		RangeSweep(unsigned lowest, unsigned highest, unsigned step, unsigned count,
+			unsigned threads) :
+		min_range(lowest),
+		granularity(step),
+		range_count(count),
+		possible_vals((highest - lowest) / step + 1)
+		{
+			for (unsigned i = 0; i < range_count; ++i) permutations *= possible_vals;
+
+			// splitting into more tasks than threads so that stealing can even them out
+			task_count = std::min<unsigned long long>(permutations,
+				(unsigned long long)threads * 16);
+			chunk = (permutations + task_count - 1) / task_count;
+			task_count = (permutations + chunk - 1) / chunk;
+		}
+
+		void decode(unsigned long long p, std::vector<unsigned>& ranges) const
+		{
+			ranges.resize(range_count);
+			for (unsigned i = 0; i < range_count; ++i)
+			{
+				ranges[i] = min_range + (p % possible_vals) * granularity;
+				p /= possible_vals;
+			}
+		}
+
+		// first permutation of a task and the one after its last
+		inline unsigned long long begin(unsigned long long task) const
+		{
+			return task * chunk;
+		}
+
+		inline unsigned long long end(unsigned long long task) const
+		{
+			return std::min(begin(task) + chunk, permutations);
+		}
+	};
+
+	Optimizer::Optimizer(unsigned thread_count) :
+	_pool(thread_count)
+	{}
+
+	/**
+	 * Backtests every permutation of ranges from min_range to max_range in
+	 * steps of granularity. The candles are shared between all of the
+	 * workers and are not copied. Strategies that can batch are run for
+	 * groups of permutations in one pass over the candles. Every
+	 * permutation is scored with a SimAccount, and only the top_k with the
+	 * best return are backtested again with a PaperAccount for their full
+	 * statistics. Those are then ordered by the metric.
+	 *
+	 * @param	strategy		strategy to optimize the ranges of
+	 * @param	candles			history to backtest on
+	 * @param	metric			what to order the best accounts by
+	 * @param	top_k			max amount of accounts to return
+	 * @return					best accounts, sorted best first
+	 */
+	std::vector<PaperAccount> Optimizer::optimize(const Strategy& strategy,
+		const PriceHistory& candles, double principal, int leverage,
+		double fee, double order_minimum, bool shorting_enabled,
+		unsigned min_range, unsigned max_range, unsigned granularity,
+		Metric metric, unsigned top_k)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+
+		if (granularity == 0 || min_range == 0 || min_range > max_range)
+		{
+			ERROR("Optimizer: ranges must be in the form 0 < min <= max with a granularity above 0");
+			return {};
+		}
+
+		if (candles.size() < max_range)
+		{
+			ERROR("Optimizer: %u candles were given but at least %u are required",
+				candles.size(), max_range);
+			return {};
+		}
+
+		if (top_k == 0) return {};
+
+		RangeSweep sweep(min_range, max_range, granularity, strategy.indicator_count(),
+			_pool.size());
+
+		INFO("Optimizer: backtesting %llu permutations of %s on %u threads",
+			sweep.permutations, strategy.filename(), _pool.size());
+
+		SimConfig config;
+		config.principal = principal;
+		config.leverage = leverage;
+		config.fee = fee;
+		config.order_minimum = order_minimum;
+		config.shorting_enabled = shorting_enabled;
+
+		// every permutation has an account in one array that shares the config
+		std::vector<SimAccount> accounts(sweep.permutations,
+			SimAccount(config, candles.front().open()));
+
+		for (unsigned long long t = 0; t < sweep.task_count; ++t)
+		{
+			_pool.push([&, t]()
+			{
+				unsigned long long first = sweep.begin(t);
+				unsigned long long last = sweep.end(t);
+
+				if (!strategy.is_batchable())
+				{
+					std::vector<unsigned> ranges;
+
+					// the worker's arena holds the chart of every permutation of the task
+					Arena& arena = Arena::local();
+					arena.reset();
+
+					Chart chart(arena);
+					std::vector<short> actions;
+
+					for (unsigned long long p = first; p < last; ++p)
+					{
+						sweep.decode(p, ranges);
+						backtest_permutation(accounts[p], candles, &strategy, ranges,
+							max_range, chart, actions);
+					}
+
+					return;
+				}
+
+				std::vector<std::vector<unsigned>> batch_ranges;
+				std::vector<SimAccount> batch;
+				std::vector<Chart> charts;
+				std::vector<std::vector<short>> batch_actions;
+
+				// groups of permutations share one pass over the candles
+				for (unsigned long long p = first; p < last; p += BATCH_SIZE)
+				{
+					unsigned size = std::min<unsigned long long>(BATCH_SIZE, last - p);
+
+					batch_ranges.resize(size);
+					for (unsigned i = 0; i < size; ++i) sweep.decode(p + i, batch_ranges[i]);
+
+					batch.assign(accounts.begin() + p, accounts.begin() + p + size);
+
+					if (!backtest_batch(batch, candles, &strategy, batch_ranges, max_range,
+						charts, batch_actions))
+					{
+						for (SimAccount& acc : batch) acc.fail();
+					}
+
+					std::copy(batch.begin(), batch.end(), accounts.begin() + p);
+				}
+			});
+		}
+
+		_pool.wait();
+
+		std::vector<unsigned> best = best_accounts(accounts, top_k);
+		std::vector<PaperAccount> out(best.size());
+
+		// the winners are run again for the statistics the metric needs
+		for (unsigned w = 0; w < best.size(); ++w)
+		{
+			_pool.push([&, w]()
+			{
+				std::vector<unsigned> ranges;
+				sweep.decode(best[w], ranges);
+
+				Arena::Scope scope(Arena::local());
+				Chart chart(Arena::local());
+				std::vector<short> actions;
+
+				out[w] = PaperAccount(principal, leverage, fee, order_minimum,
+					candles.front().open(), shorting_enabled, candles.interval(),
+					std::vector<int>(ranges.begin(), ranges.end()));
+
+				backtest_permutation(out[w], candles, &strategy, ranges, max_range,
+					chart, actions);
+			});
+		}
+
+		_pool.wait();
+
+		std::stable_sort(out.begin(), out.end(),
+			[metric](const PaperAccount& a, const PaperAccount& b)
+			{
+				return get_metric(a, metric) > get_metric(b, metric);
+			});
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - t0);
+		SUCCESS("Optimizer: %s finished in %fs", strategy.filename(), ms.count() / 1000.0);
+
+		return out;
+	}
+
+	/**
+	 * Validates the choice of ranges out of sample. The history is split
+	 * into steps of rolling windows. The best ranges of each in sample
+	 * window are found by backtesting every permutation, and they are then
+	 * traded on the out of sample window that follows it.
+	 *
+	 * The actions of each permutation are calculated once over the whole
+	 * history and shared by every window, so the indicators are carried
+	 * across the windows instead of being calculated again for each one.
+	 * Strategies that can batch calculate them for groups of permutations
+	 * in one pass.
+	 * They only ever depend on candles before the one they act on, so no
+	 * window sees past its end.
+	 *
+	 * @param	strategy	strategy to walk forward
+	 * @param	candles		history to walk over
+	 * @param	account		settings of the accounts to backtest with
+	 * @param	config		ranges to search and sizes of the windows
+	 * @return				every step and the out of sample trades, which
+	 * 						has no steps if the history was too short
+	 */
+	WalkForward Optimizer::walk_forward(const Strategy& strategy,
+		const PriceHistory& candles, const SimConfig& account,
+		const WalkForwardConfig& config)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		WalkForward out;
+
+		if (config.granularity == 0 || config.min_range == 0
+			|| config.min_range > config.max_range)
+		{
+			ERROR("Optimizer: ranges must be in the form 0 < min <= max with a granularity above 0");
+			return out;
+		}
+
+		if (config.in_sample == 0 || config.out_of_sample == 0)
+		{
+			ERROR("Optimizer: in and out of sample windows must have candles");
+			return out;
+		}
+
+		// the first window starts once every indicator has a full range
+		unsigned window = config.max_range;
+		unsigned first = window - 1;
+
+		if (candles.size() < first + config.in_sample + config.out_of_sample)
+		{
+			ERROR("Optimizer: %u candles were given but at least %u are required",
+				candles.size(), first + config.in_sample + config.out_of_sample);
+			return out;
+		}
+
+		unsigned step_count = (candles.size() - first - config.in_sample) / config.out_of_sample;
+		RangeSweep sweep(config.min_range, config.max_range, config.granularity,
+			strategy.indicator_count(), _pool.size());
+
+		INFO("Optimizer: walking %s forward over %u steps of %llu permutations on %u threads",
+			strategy.filename(), step_count, sweep.permutations, _pool.size());
+
+		// best return and permutation of every step, found by each task
+		typedef std::pair<double, unsigned long long> Best;
+		const Best none(-std::numeric_limits<double>::infinity(), 0);
+		std::vector<std::vector<Best>> task_best(sweep.task_count,
+			std::vector<Best>(step_count, none));
+
+		for (unsigned long long t = 0; t < sweep.task_count; ++t)
+		{
+			_pool.push([&, t]()
+			{
+				unsigned long long begin = sweep.begin(t);
+				unsigned long long last = sweep.end(t);
+
+				std::vector<Best>& best = task_best[t];
+
+				// strategies that cannot batch get each permutation on its own
+				unsigned group = strategy.is_batchable() ? BATCH_SIZE : 1;
+
+				// the charts span the whole history and are reused by every group
+				std::vector<std::vector<unsigned>> ranges;
+				std::vector<Chart> charts;
+				std::vector<std::vector<short>> actions;
+
+				for (unsigned long long p = begin; p < last; p += group)
+				{
+					unsigned size = std::min<unsigned long long>(group, last - p);
+
+					ranges.resize(size);
+					for (unsigned i = 0; i < size; ++i) sweep.decode(p + i, ranges[i]);
+
+					try
+					{
+						strategy.execute_batch(charts, actions, candles, ranges, window);
+					}
+					catch (const std::string&)
+					{
+						continue;
+					}
+
+					for (unsigned i = 0; i < size; ++i)
+					{
+						for (unsigned s = 0; s < step_count; ++s)
+						{
+							unsigned start = first + s * config.out_of_sample;
+							SimAccount acc(account, candles.closes()[start]);
+
+							if (!backtest_actions(acc, candles, actions[i].data(), start,
+								start + config.in_sample)) continue;
+
+							double score = acc.pct_return();
+							if (score > best[s].first) best[s] = { score, p + i };
+						}
+					}
+				}
+			});
+		}
+
+		_pool.wait();
+
+		out.account = PaperAccount(account.principal, (int)account.leverage,
+			account.fee, account.order_minimum, candles.closes()[first + config.in_sample],
+			account.shorting_enabled, candles.interval(), {});
+
+		Chart chart;
+		std::vector<short> actions;
+		unsigned long long chosen = sweep.permutations;
+
+		for (unsigned s = 0; s < step_count; ++s)
+		{
+			// permutations are in order within and across tasks, so ties go to the first
+			Best best = none;
+			for (const std::vector<Best>& results : task_best)
+			{
+				if (results[s].first > best.first) best = results[s];
+			}
+
+			if (best.first == none.first) continue;
+
+			WalkForwardStep step;
+			step.start = first + s * config.out_of_sample;
+			step.split = step.start + config.in_sample;
+			step.end = step.split + config.out_of_sample;
+			step.in_sample_return = best.first;
+			sweep.decode(best.second, step.ranges);
+
+			// steps often choose the same ranges as the one before them
+			if (best.second != chosen)
+			{
+				try
+				{
+					strategy.execute_series(chart, actions, candles, step.ranges, window);
+				}
+				catch (const std::string& err)
+				{
+					ERROR("Optimizer: Strategy: %s", err);
+					break;
+				}
+
+				chosen = best.second;
+			}
+
+			double before = out.account.equity();
+
+			if (!backtest_actions(out.account, candles, actions.data(), step.split, step.end))
+			{
+				ERROR("Optimizer: out of sample trading failed at step %u", s);
+				break;
+			}
+
+			step.out_of_sample_return = (before > 0.0) ? out.account.equity() / before - 1.0 : 0.0;
+			out.steps.push_back(std::move(step));
+		}
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - t0);
+		SUCCESS("Optimizer: walked %s forward in %fs with a return of %f%% out of sample",
+			strategy.filename(), ms.count() / 1000.0, out.account.pct_return() * 100.0);
+
+		return out;
+	}
+}
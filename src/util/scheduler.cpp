@@ -0,0 +1,83 @@
+#include <util/scheduler.h>
+
+// standard library
+#include <algorithm>
+
+namespace daytrender
+{
+	// orders the heap so that the earliest deadline is on top
+	bool Scheduler::later(const Entry& a, const Entry& b)
+	{
+		if (a.when != b.when) return a.when > b.when;
+		return a.order > b.order;
+	}
+
+	/**
+	 * Queues a task to run at a time. A time that has already passed runs
+	 * the task as soon as possible. This can be called from inside a task,
+	 * which is how repeating work reschedules itself.
+	 */
+	void Scheduler::schedule(Clock::time_point when, std::function<void()> task)
+	{
+		bool earliest;
+
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_heap.push_back({ when, _order++, std::move(task) });
+			std::push_heap(_heap.begin(), _heap.end(), later);
+			earliest = _heap.front().order == _order - 1;
+		}
+
+		// the sleeping thread only has to wake if its deadline moved up
+		if (earliest) _cv.notify_one();
+	}
+
+	/**
+	 * Runs tasks as they come due until stop() is called. The tasks run on
+	 * the calling thread without the lock held.
+	 */
+	void Scheduler::run()
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+
+		while (!_stopped)
+		{
+			if (_heap.empty())
+			{
+				_cv.wait(lock);
+				continue;
+			}
+
+			Clock::time_point when = _heap.front().when;
+
+			if (Clock::now() < when)
+			{
+				_cv.wait_until(lock, when);
+				continue;
+			}
+
+			std::pop_heap(_heap.begin(), _heap.end(), later);
+			std::function<void()> task = std::move(_heap.back().task);
+			_heap.pop_back();
+
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+
+	/**
+	 * Makes run() return once the task it is running, if any, is done.
+	 * Queued tasks are kept but a stopped scheduler does not run again.
+	 * This locks, so it must not be called from a signal handler.
+	 */
+	void Scheduler::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_stopped = true;
+		}
+
+		_cv.notify_all();
+	}
+}
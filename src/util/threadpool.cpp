@@ -0,0 +1,169 @@
+#include <util/threadpool.h>
+
+// standard library
+#include <exception>
+#include <string>
+
+// external libraries
+#include <hirzel/logger.h>
+
+namespace daytrender
+{
+	thread_local const ThreadPool *ThreadPool::_worker_pool = nullptr;
+	thread_local unsigned ThreadPool::_worker_index = 0;
+
+	/**
+	 * @param	thread_count	amount of workers, 0 for one per core
+	 */
+	ThreadPool::ThreadPool(unsigned thread_count)
+	{
+		if (thread_count == 0)
+			thread_count = std::thread::hardware_concurrency();
+		if (thread_count == 0)
+			thread_count = 1;
+
+		_queues.reserve(thread_count);
+		for (unsigned i = 0; i < thread_count; ++i)
+		{
+			_queues.push_back(std::make_unique<Queue>());
+		}
+
+		_threads.reserve(thread_count);
+		for (unsigned i = 0; i < thread_count; ++i)
+		{
+			_threads.emplace_back(&ThreadPool::work, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_running = false;
+		}
+
+		_task_cv.notify_all();
+
+		for (std::thread& t : _threads)
+		{
+			t.join();
+		}
+	}
+
+	/**
+	 * Queues a task. Tasks pushed from inside a worker go to that worker's
+	 * own queue, otherwise they are spread across the workers.
+	 */
+	void ThreadPool::push(std::function<void()> task)
+	{
+		unsigned index = (_worker_pool == this)
+			? _worker_index
+			: _next_queue++ % _queues.size();
+
+		_unfinished++;
+
+		// counted before it is visible so that popping it cannot underflow
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_queued++;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_queues[index]->mtx);
+			_queues[index]->tasks.push_back(std::move(task));
+		}
+
+		_task_cv.notify_one();
+	}
+
+	/**
+	 * Blocks until every queued task has finished. This must not be called
+	 * from inside one of the pool's tasks.
+	 */
+	void ThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		_done_cv.wait(lock, [this]{ return _unfinished == 0; });
+	}
+
+	bool ThreadPool::pop(unsigned index, std::function<void()>& task)
+	{
+		// newest task from own queue
+		{
+			Queue& own = *_queues[index];
+			std::lock_guard<std::mutex> lock(own.mtx);
+
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				_queued--;
+				return true;
+			}
+		}
+
+		// oldest task from any other queue
+		for (unsigned i = 1; i < _queues.size(); ++i)
+		{
+			Queue& other = *_queues[(index + i) % _queues.size()];
+			std::lock_guard<std::mutex> lock(other.mtx);
+
+			if (!other.tasks.empty())
+			{
+				task = std::move(other.tasks.front());
+				other.tasks.pop_front();
+				_queued--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::work(unsigned index)
+	{
+		_worker_pool = this;
+		_worker_index = index;
+
+		std::function<void()> task;
+
+		while (true)
+		{
+			if (pop(index, task))
+			{
+				// a task that throws must not take the worker down with it
+				try
+				{
+					task();
+				}
+				catch (const std::exception& e)
+				{
+					ERROR("Thread pool: task failed: %s", e.what());
+				}
+				catch (const std::string& err)
+				{
+					ERROR("Thread pool: task failed: %s", err);
+				}
+				catch (...)
+				{
+					ERROR("Thread pool: task failed with an unknown error");
+				}
+
+				task = nullptr;
+
+				if (--_unfinished == 0)
+				{
+					std::lock_guard<std::mutex> lock(_mtx);
+					_done_cv.notify_all();
+				}
+
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(_mtx);
+			_task_cv.wait(lock, [this]{ return _queued > 0 || !_running; });
+
+			if (!_running && _queued == 0) return;
+		}
+	}
+}
@@ -0,0 +1,390 @@
+#include <util/vectorops.h>
+
+// standard library
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOROPS_X86
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace daytrender
+{
+	namespace vectorops
+	{
+		struct Table
+		{
+			void (*scaled_diff)(const double*, const double*, double, double, double*, unsigned);
+			void (*add_scaled)(const double*, const double*, double, double*, unsigned);
+			void (*min)(const double*, const double*, double*, unsigned);
+			void (*max)(const double*, const double*, double*, unsigned);
+			void (*true_range)(const double*, const double*, const double*, double*, unsigned);
+			void (*normalize)(const double*, const double*, const double*, double, double*, unsigned);
+			void (*stddev)(const double*, const double*, double*, unsigned);
+			const char *isa;
+		};
+
+		// SCALAR	============================================================
+
+		static void scaled_diff_scalar(const double* a, const double* b, double scale,
+			double shift, double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i) out[i] = (a[i] - b[i]) * scale + shift;
+		}
+
+		static void add_scaled_scalar(const double* a, const double* b, double scale,
+			double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i) out[i] = a[i] + b[i] * scale;
+		}
+
+		static void min_scalar(const double* a, const double* b, double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i) out[i] = (b[i] < a[i]) ? b[i] : a[i];
+		}
+
+		static void max_scalar(const double* a, const double* b, double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i) out[i] = (b[i] > a[i]) ? b[i] : a[i];
+		}
+
+		static void true_range_scalar(const double* high, const double* low,
+			const double* prev, double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i)
+			{
+				double tr = high[i] - low[i];
+				double up = std::fabs(high[i] - prev[i]);
+				double down = std::fabs(low[i] - prev[i]);
+				if (up > tr) tr = up;
+				if (down > tr) tr = down;
+				out[i] = tr;
+			}
+		}
+
+		static void normalize_scalar(const double* x, const double* lo, const double* hi,
+			double scale, double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i)
+			{
+				double range = hi[i] - lo[i];
+				out[i] = (range == 0.0) ? 0.0 : (x[i] - lo[i]) / range * scale;
+			}
+		}
+
+		static void stddev_scalar(const double* mean, const double* mean_sq,
+			double* out, unsigned n)
+		{
+			for (unsigned i = 0; i < n; ++i)
+			{
+				double var = mean_sq[i] - mean[i] * mean[i];
+				out[i] = std::sqrt(var > 0.0 ? var : 0.0);
+			}
+		}
+
+		static const Table scalar_table =
+		{
+			scaled_diff_scalar,
+			add_scaled_scalar,
+			min_scalar,
+			max_scalar,
+			true_range_scalar,
+			normalize_scalar,
+			stddev_scalar,
+			"scalar"
+		};
+
+#ifdef VECTOROPS_X86
+
+		// SSE2		============================================================
+
+		TARGET_SSE2 static void scaled_diff_sse2(const double* a, const double* b,
+			double scale, double shift, double* out, unsigned n)
+		{
+			__m128d s = _mm_set1_pd(scale);
+			__m128d t = _mm_set1_pd(shift);
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d d = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+				_mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(d, s), t));
+			}
+			scaled_diff_scalar(a + i, b + i, scale, shift, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void add_scaled_sse2(const double* a, const double* b,
+			double scale, double* out, unsigned n)
+		{
+			__m128d s = _mm_set1_pd(scale);
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d p = _mm_mul_pd(_mm_loadu_pd(b + i), s);
+				_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), p));
+			}
+			add_scaled_scalar(a + i, b + i, scale, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void min_sse2(const double* a, const double* b, double* out,
+			unsigned n)
+		{
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				_mm_storeu_pd(out + i, _mm_min_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			}
+			min_scalar(a + i, b + i, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void max_sse2(const double* a, const double* b, double* out,
+			unsigned n)
+		{
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				_mm_storeu_pd(out + i, _mm_max_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			}
+			max_scalar(a + i, b + i, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void true_range_sse2(const double* high, const double* low,
+			const double* prev, double* out, unsigned n)
+		{
+			__m128d sign = _mm_set1_pd(-0.0);
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d h = _mm_loadu_pd(high + i);
+				__m128d l = _mm_loadu_pd(low + i);
+				__m128d p = _mm_loadu_pd(prev + i);
+				__m128d up = _mm_andnot_pd(sign, _mm_sub_pd(h, p));
+				__m128d down = _mm_andnot_pd(sign, _mm_sub_pd(l, p));
+				__m128d tr = _mm_max_pd(_mm_sub_pd(h, l), _mm_max_pd(up, down));
+				_mm_storeu_pd(out + i, tr);
+			}
+			true_range_scalar(high + i, low + i, prev + i, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void normalize_sse2(const double* x, const double* lo,
+			const double* hi, double scale, double* out, unsigned n)
+		{
+			__m128d s = _mm_set1_pd(scale);
+			__m128d zero = _mm_setzero_pd();
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d l = _mm_loadu_pd(lo + i);
+				__m128d range = _mm_sub_pd(_mm_loadu_pd(hi + i), l);
+				__m128d flat = _mm_cmpeq_pd(range, zero);
+				__m128d val = _mm_mul_pd(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(x + i), l), range), s);
+				_mm_storeu_pd(out + i, _mm_andnot_pd(flat, val));
+			}
+			normalize_scalar(x + i, lo + i, hi + i, scale, out + i, n - i);
+		}
+
+		TARGET_SSE2 static void stddev_sse2(const double* mean, const double* mean_sq,
+			double* out, unsigned n)
+		{
+			__m128d zero = _mm_setzero_pd();
+			unsigned i = 0;
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d m = _mm_loadu_pd(mean + i);
+				__m128d var = _mm_sub_pd(_mm_loadu_pd(mean_sq + i), _mm_mul_pd(m, m));
+				_mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_max_pd(var, zero)));
+			}
+			stddev_scalar(mean + i, mean_sq + i, out + i, n - i);
+		}
+
+		static const Table sse2_table =
+		{
+			scaled_diff_sse2,
+			add_scaled_sse2,
+			min_sse2,
+			max_sse2,
+			true_range_sse2,
+			normalize_sse2,
+			stddev_sse2,
+			"sse2"
+		};
+
+		// AVX2		============================================================
+
+		TARGET_AVX2 static void scaled_diff_avx2(const double* a, const double* b,
+			double scale, double shift, double* out, unsigned n)
+		{
+			__m256d s = _mm256_set1_pd(scale);
+			__m256d t = _mm256_set1_pd(shift);
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+				_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(d, s), t));
+			}
+			scaled_diff_scalar(a + i, b + i, scale, shift, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void add_scaled_avx2(const double* a, const double* b,
+			double scale, double* out, unsigned n)
+		{
+			__m256d s = _mm256_set1_pd(scale);
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256d p = _mm256_mul_pd(_mm256_loadu_pd(b + i), s);
+				_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), p));
+			}
+			add_scaled_scalar(a + i, b + i, scale, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void min_avx2(const double* a, const double* b, double* out,
+			unsigned n)
+		{
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				_mm256_storeu_pd(out + i, _mm256_min_pd(_mm256_loadu_pd(a + i),
+					_mm256_loadu_pd(b + i)));
+			}
+			min_scalar(a + i, b + i, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void max_avx2(const double* a, const double* b, double* out,
+			unsigned n)
+		{
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				_mm256_storeu_pd(out + i, _mm256_max_pd(_mm256_loadu_pd(a + i),
+					_mm256_loadu_pd(b + i)));
+			}
+			max_scalar(a + i, b + i, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void true_range_avx2(const double* high, const double* low,
+			const double* prev, double* out, unsigned n)
+		{
+			__m256d sign = _mm256_set1_pd(-0.0);
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256d h = _mm256_loadu_pd(high + i);
+				__m256d l = _mm256_loadu_pd(low + i);
+				__m256d p = _mm256_loadu_pd(prev + i);
+				__m256d up = _mm256_andnot_pd(sign, _mm256_sub_pd(h, p));
+				__m256d down = _mm256_andnot_pd(sign, _mm256_sub_pd(l, p));
+				__m256d tr = _mm256_max_pd(_mm256_sub_pd(h, l), _mm256_max_pd(up, down));
+				_mm256_storeu_pd(out + i, tr);
+			}
+			true_range_scalar(high + i, low + i, prev + i, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void normalize_avx2(const double* x, const double* lo,
+			const double* hi, double scale, double* out, unsigned n)
+		{
+			__m256d s = _mm256_set1_pd(scale);
+			__m256d zero = _mm256_setzero_pd();
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256d l = _mm256_loadu_pd(lo + i);
+				__m256d range = _mm256_sub_pd(_mm256_loadu_pd(hi + i), l);
+				__m256d flat = _mm256_cmp_pd(range, zero, _CMP_EQ_OQ);
+				__m256d val = _mm256_mul_pd(_mm256_div_pd(_mm256_sub_pd(
+					_mm256_loadu_pd(x + i), l), range), s);
+				_mm256_storeu_pd(out + i, _mm256_andnot_pd(flat, val));
+			}
+			normalize_scalar(x + i, lo + i, hi + i, scale, out + i, n - i);
+		}
+
+		TARGET_AVX2 static void stddev_avx2(const double* mean, const double* mean_sq,
+			double* out, unsigned n)
+		{
+			__m256d zero = _mm256_setzero_pd();
+			unsigned i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m256d m = _mm256_loadu_pd(mean + i);
+				__m256d var = _mm256_sub_pd(_mm256_loadu_pd(mean_sq + i), _mm256_mul_pd(m, m));
+				_mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_max_pd(var, zero)));
+			}
+			stddev_scalar(mean + i, mean_sq + i, out + i, n - i);
+		}
+
+		static const Table avx2_table =
+		{
+			scaled_diff_avx2,
+			add_scaled_avx2,
+			min_avx2,
+			max_avx2,
+			true_range_avx2,
+			normalize_avx2,
+			stddev_avx2,
+			"avx2"
+		};
+
+#endif
+
+		static const Table& table()
+		{
+			static const Table& selected = []() -> const Table&
+			{
+#ifdef VECTOROPS_X86
+				__builtin_cpu_init();
+				if (__builtin_cpu_supports("avx2")) return avx2_table;
+				if (__builtin_cpu_supports("sse2")) return sse2_table;
+#endif
+				return scalar_table;
+			}();
+
+			return selected;
+		}
+
+		void scaled_diff(const double* a, const double* b, double scale,
+			double shift, double* out, unsigned n)
+		{
+			table().scaled_diff(a, b, scale, shift, out, n);
+		}
+
+		void add_scaled(const double* a, const double* b, double scale,
+			double* out, unsigned n)
+		{
+			table().add_scaled(a, b, scale, out, n);
+		}
+
+		void min(const double* a, const double* b, double* out, unsigned n)
+		{
+			table().min(a, b, out, n);
+		}
+
+		void max(const double* a, const double* b, double* out, unsigned n)
+		{
+			table().max(a, b, out, n);
+		}
+
+		void true_range(const double* high, const double* low,
+			const double* prev, double* out, unsigned n)
+		{
+			table().true_range(high, low, prev, out, n);
+		}
+
+		void normalize(const double* x, const double* lo, const double* hi,
+			double scale, double* out, unsigned n)
+		{
+			table().normalize(x, lo, hi, scale, out, n);
+		}
+
+		void stddev(const double* mean, const double* mean_sq, double* out,
+			unsigned n)
+		{
+			table().stddev(mean, mean_sq, out, n);
+		}
+
+		const char *isa()
+		{
+			return table().isa;
+		}
+	}
+}